@@ -4,6 +4,7 @@ use strict;
 use Cwd qw(abs_path);
 use File::Basename qw(dirname);
 use JSON;
+use POSIX qw(ceil frexp);
 
 use lib dirname($0);
 use Common;
@@ -25,20 +26,71 @@ sub standard_deviation {
 	return sqrt(sum(map {($_ - $average)**2} @_) / scalar(@_));
 }
 
+# Must match HISTOGRAM_SUB_BUCKETS and HISTOGRAM_MAX_EXPONENT in
+# src/histogram.h
+my $histogram_sub_buckets = 16;
+my $histogram_max_exponent = 14;
+
+# Merge the latency histograms output by the clients, see src/histogram.h
+sub merge_histogram {
+	my ($merged, $latency) = @_;
+	return unless ($latency && $latency->{"sample size"});
+	if (!$merged->{count} || $latency->{min} < $merged->{min}) {
+		$merged->{min} = $latency->{min};
+	}
+	if (!$merged->{count} || $latency->{max} > $merged->{max}) {
+		$merged->{max} = $latency->{max};
+	}
+	$merged->{count} += $latency->{"sample size"};
+	$merged->{buckets}{$_->[0]} += $_->[1] for (@{$latency->{histogram}});
+}
+
+# Estimate a quantile as the middle of the bucket it falls in, as done by
+# histogram_quantile()
+sub histogram_quantile {
+	my ($merged, $q) = @_;
+	return 0 unless $merged->{count};
+	my $rank = ceil($q * $merged->{count});
+	$rank = 1 if $rank == 0;
+	my @bounds = sort {$a <=> $b} keys %{$merged->{buckets}};
+	my $seen = 0;
+	for my $i (0 .. $#bounds) {
+		my $lower_bound = $bounds[$i];
+		$seen += $merged->{buckets}{$lower_bound};
+		next if $seen < $rank;
+		return $merged->{min} if $lower_bound == 0;
+		return $merged->{max} if $lower_bound >= 2 ** $histogram_max_exponent;
+		my (undef, $exponent) = frexp($lower_bound);
+		my $width = 2 ** ($exponent - 1) / $histogram_sub_buckets;
+		my $value = $lower_bound + $width / 2;
+		$value = $merged->{min} if $value < $merged->{min};
+		$value = $merged->{max} if $value > $merged->{max};
+		return $value;
+	}
+	return $merged->{max};
+}
+
 sub client_stats {
 	my @client_files = grep {/r\d+_c\d+_stats.json/} glob('r*_c*_stats.json');
 	my %stats;
+	my %histograms;
 	for my $f (@client_files) {
 		my $data = Common::read_json_file($f);
 		for my $k (keys %$data) {
 			next if $k eq "name";
 			push @{$stats{$k . " average latency"}}, $data->{$k}{"average latency"};
 			push @{$stats{$k . " rate"}}, $data->{$k}{"rate"};
+			merge_histogram(\%{$histograms{$k}}, $data->{$k}{latency});
 		}
 	}
 
 	my %client;
 	$client{$_} = average(@{$stats{$_}}) for keys %stats;
+	for my $k (keys %histograms) {
+		for my $p (50, 90, 99, 99.9) {
+			$client{"$k latency p$p"} = histogram_quantile($histograms{$k}, $p / 100);
+		}
+	}
 	$client{throughput} = $client{"get rate"} + $client{"put rate"} + $client{"rotx rate"};
 	return \%client;
 }
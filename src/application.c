@@ -10,8 +10,10 @@
 #include <ROOT-Sim.h>
 #include <assert.h>
 #include <getopt.h>
+#include <limits.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <time.h>
 
 typedef struct event {
@@ -201,25 +203,62 @@ int main(int argc, char **argv)
 	unsigned int num_keys = param_get_uint(cluster_obj, "keys");
 	double clock_skew = param_get_double(cluster_obj, "clock_skew");
 	unsigned int num_cores = param_get_uint(cluster_obj, "cores_per_server");
+	const char *store = param_get_string_default(cluster_obj, "store", "hash");
+	int dense_store = 0;
+	if (!strcmp(store, "dense")) {
+		if (num_keys == UINT_MAX) {
+			fprintf(stderr, "The dense store needs a bounded number of keys.\n");
+			exit(1);
+		}
+		dense_store = 1;
+	} else if (strcmp(store, "hash")) {
+		fprintf(stderr, "Store \"%s\" is unknown.\n", store);
+		exit(1);
+	}
+	unsigned int inline_versions = param_get_uint_default(cluster_obj,
+			"inline_versions", 0);
 	cluster_config_t *cluster = cluster_new(
 			__real_malloc, num_replicas, num_partitions_per_replica,
-			num_keys, clock_skew);
+			num_keys, clock_skew, dense_store, inline_versions);
 
 	/* Network */
 	lpid_t _num_lps = num_partitions_per_replica * num_replicas
 		* (1 + num_clients_per_partition);
-	network_config_t *network = network_setup(_num_lps);
+	network_config_t *network = network_setup(_num_lps, num_replicas);
 
 	/* Partitions */
-	unsigned int tree_fanout = param_get_uint(cluster_obj, "tree_fanout");
+	const char *topology = param_get_string_default(cluster_obj,
+			"gst_topology", "tree");
+	gst_topology_t gst_topology = GST_TOPOLOGY_TREE;
+	unsigned int tree_fanout = 1;
+	if (!strcmp(topology, "tree")) {
+		tree_fanout = param_get_uint(cluster_obj, "tree_fanout");
+	} else if (!strcmp(topology, "flat")) {
+		// Every other partition is a child of the root
+		if (num_partitions_per_replica > 1) {
+			tree_fanout = num_partitions_per_replica - 1;
+		}
+	} else if (!strcmp(topology, "broadcast")) {
+		gst_topology = GST_TOPOLOGY_BROADCAST;
+	} else {
+		fprintf(stderr, "GST topology \"%s\" is unknown.\n", topology);
+		exit(1);
+	}
 	void setup_server(lpid_t lpid, replica_t replica, partition_t partition) {
 		snprintf(buf, buf_size, "server %d of replica %d", partition, replica);
 		lpid = new_process(buf);
 		cluster_set_lpid(cluster, replica, partition, lpid);
 		server_setup(lpid, cluster, replica, partition, network, tree_fanout,
-				num_cores);
+				gst_topology, num_cores);
 	}
 	foreach_server(cluster, setup_server);
+	void setup_server_peers(lpid_t lpid, replica_t replica,
+			partition_t partition) {
+		(void) replica;
+		(void) partition;
+		server_setup_peers(lpid);
+	}
+	foreach_server(cluster, setup_server_peers);
 
 	/* Clients */
 	struct json_object *client_obj = param_get_object_root("client");
@@ -5,6 +5,7 @@
 #include "common.h"
 #include "event.h"
 #include "gentle_rain.h"
+#include "histogram.h"
 #include "network.h"
 #include "output.h"
 #include "parameters.h"
@@ -18,8 +19,7 @@
 #include <time.h>
 
 typedef struct {
-	int count;
-	double latency_sum;
+	histogram_t latencies;
 } request_stats_t;
 
 struct client_state {
@@ -52,8 +52,7 @@ int client_register_request_type(client_state_t *state, const char *name)
 	state->request_stats = realloc(state->request_stats,
 			sizeof(*state->request_stats) * state->num_request_types);
 	request_stats_t *stats = malloc(sizeof(request_stats_t));
-	stats->count = 0;
-	stats->latency_sum = 0;
+	histogram_init(&stats->latencies);
 	state->request_stats[id] = stats;
 	return id;
 }
@@ -82,9 +81,8 @@ simtime_t client_finish_request(client_state_t *state, int request_type)
 	state->last_request_duration = state->now - state->request_time;
 	state->request_time = -1;
 	if (state->now >= app_params.ignore_initial_seconds) {
-		request_stats_t *request_stats = state->request_stats[request_type];
-		++request_stats->count;
-		request_stats->latency_sum += state->last_request_duration;
+		histogram_add(&state->request_stats[request_type]->latencies,
+				state->last_request_duration);
 	}
 	return state->last_request_duration;
 }
@@ -161,7 +159,9 @@ static void client_init(lpid_t lpid, simtime_t now, client_state_t *state)
 	assert(state->config->cluster->num_partitions < (unsigned int) INT_MAX);
 	state->last_used_partition = random_uint(0,
 			state->config->cluster->num_partitions);
-	state->network = network_init(state->config->network);
+	state->network = network_init(state->config->network,
+			state->config->tied_to_partition ? 1
+			: state->config->cluster->num_partitions);
 	state->start_time = now;
 	state->now = now;
 	state->request_time = -1;
@@ -172,29 +172,6 @@ static void client_init(lpid_t lpid, simtime_t now, client_state_t *state)
 	state->request_stats = NULL;
 
 	struct json_object *network_obj = param_get_object_root("network");
-	double intra_datacenter_network_delay = param_get_double(
-			network_obj, "intra_datacenter_delay");
-
-	if (state->config->tied_to_partition) {
-		lpid_t server_lpid = cluster_get_lpid(state->config->cluster,
-				state->config->replica, state->config->partition);
-		network_set_delay(state->config->network, lpid, server_lpid,
-				intra_datacenter_network_delay);
-		network_set_delay(state->config->network, server_lpid, lpid,
-				intra_datacenter_network_delay);
-	} else {
-		// Set network delay with servers in the replica
-		void set_network_delay(lpid_t server_lpid, partition_t partition) {
-			(void) partition; // Unused parameter;
-			network_set_delay(state->config->network, lpid, server_lpid,
-					intra_datacenter_network_delay);
-			network_set_delay(state->config->network, server_lpid, lpid,
-					intra_datacenter_network_delay);
-		}
-		foreach_partition(state->config->cluster, state->config->replica,
-				set_network_delay);
-	}
-
 	double transmission_rate = param_get_double(network_obj, "transmission_rate");
 	network_set_transmission_rate(state->config->network, lpid, transmission_rate);
 
@@ -242,9 +219,6 @@ static void client_process_event(lpid_t lpid, simtime_t now,
 	}
 }
 
-#define div_or_zero(a, b) \
-	(b ? a / b : 0)
-
 static void client_stats_output(client_state_t *state)
 {
 	assert_gvt();
@@ -254,14 +228,20 @@ static void client_stats_output(client_state_t *state)
 	json_object_object_add(obj, "name",
 			json_object_new_string(lp_name(state->config->lpid)));
 	for (unsigned int i = 0; i < state->num_request_types; ++i) {
-		request_stats_t *s = state->request_stats[i];
+		histogram_t *latencies = &state->request_stats[i]->latencies;
 		struct json_object *req_obj = json_object_new_object();
+		assert(latencies->count <= INT64_MAX);
 		json_object_object_add(req_obj, "count",
-				json_object_new_int64(s->count));
+				json_object_new_int64((int64_t) latencies->count));
 		json_object_object_add(req_obj, "rate",
-				json_object_new_double(s->count / elapsed));
+				json_object_new_double((double) latencies->count / elapsed));
 		json_object_object_add(req_obj, "average latency",
-				json_object_new_double(div_or_zero(s->latency_sum, s->count)));
+				json_object_new_double(histogram_average(latencies)));
+		// The buckets are kept so that the histograms of all the clients can
+		// be merged for cluster-wide percentiles
+		struct json_object *latency_obj = json_object_new_object();
+		histogram_output(latencies, latency_obj, 1);
+		json_object_object_add(req_obj, "latency", latency_obj);
 		json_object_object_add(obj, state->request_type_names[i], req_obj);
 	}
 
@@ -335,6 +315,8 @@ void client_setup(lpid_t lpid, cluster_config_t *cluster, replica_t replica,
 	}
 
 	lp_config[lpid] = config;
+	network_set_client_location(network, lpid, replica, partition,
+			config->tied_to_partition);
 	register_callbacks(lpid, client_process_event, client_on_gvt);
 }
 
@@ -9,6 +9,7 @@ typedef struct {
 	const client_config_t *config;
 	gr_tsp dependency_time;  // Maximum update timestamp of all items accessed so far
 	gr_gst gst;  // GST that the client is aware of
+	message_pool_t *messages;
 } client_state_gr_t;
 
 int get_request_type, put_request_type, rotx_request_type;
@@ -21,6 +22,7 @@ static void *gr_client_protocol_init(client_state_t *client,
 	rotx_request_type = client_register_request_type(client, "rotx");
 	client_state_gr_t *state = calloc(1, sizeof(client_state_gr_t));
 	state->config = config;
+	state->messages = message_pool_new();
 	return state;
 }
 
@@ -34,14 +36,13 @@ static void gr_client_get_request(client_state_t *client, gr_key key)
 {
 	client_state_gr_t *state = client_protocol_state(client);
 	lpid_t server_lpid = client_lpid_for_key(state->config, key);
-	gr_get_request_t *request = gr_get_request_new();
+	gr_get_request_t *request = gr_get_request_pooled(state->messages);
 	request->client_lpid = state->config->lpid;
 	request->proxy_lpid = NO_PROXY_LPID;
 	request->key = key;
 	request->gst = state->gst;
 	client_begin_request(client);
 	client_send(client, server_lpid, GR_GET_REQUEST, &request->message);
-	free(request);
 }
 
 static void gr_client_put_request(client_state_t *client, gr_key key, gr_value value)
@@ -49,7 +50,7 @@ static void gr_client_put_request(client_state_t *client, gr_key key, gr_value v
 	client_state_gr_t *state = client_protocol_state(client);
 	lpid_t server_lpid = client_lpid_for_key(state->config, key);
 	gr_tsp dependency_time = state->dependency_time;
-	gr_put_request_t *request = gr_put_request_new();
+	gr_put_request_t *request = gr_put_request_pooled(state->messages);
 	request->client_lpid = state->config->lpid;
 	request->proxy_lpid = NO_PROXY_LPID;
 	request->key = key;
@@ -57,14 +58,14 @@ static void gr_client_put_request(client_state_t *client, gr_key key, gr_value v
 	request->dependency_time = dependency_time;
 	client_begin_request(client);
 	client_send(client, server_lpid, GR_PUT_REQUEST, &request->message);
-	free(request);
 }
 
 static void gr_client_rotx_request(client_state_t *client, gr_key *keys,
 		unsigned int num_keys)
 {
 	client_state_gr_t *state = client_protocol_state(client);
-	gr_get_rotx_request_t *request = gr_get_rotx_request_new(num_keys);
+	gr_get_rotx_request_t *request = gr_get_rotx_request_pooled(
+			state->messages, num_keys);
 	request->client_lpid = state->config->lpid;
 	memcpy(gr_get_rotx_request_keys(request), keys, num_keys * sizeof(gr_key));
 	request->gst = state->gst;
@@ -72,7 +73,6 @@ static void gr_client_rotx_request(client_state_t *client, gr_key *keys,
 	lpid_t server_lpid = lpid_of_any_partition(client);
 	client_begin_request(client);
 	client_send(client, server_lpid, GR_ROTX_REQUEST, &request->message);
-	free(request);
 }
 
 static void get_response(client_state_t *client, gr_get_response_t *response)
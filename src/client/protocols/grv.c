@@ -12,6 +12,7 @@ typedef struct {
 	const client_config_t *config;
 	gr_tsp *dependency_vector;
 	gr_tsp *gst_vector;
+	message_pool_t *messages;
 } client_state_grv_t;
 
 int get_request_type, put_request_type, rotx_request_type;
@@ -27,6 +28,7 @@ static void *grv_client_init(client_state_t *client, const client_config_t *conf
 			sizeof(*state->dependency_vector));
 	state->gst_vector = calloc(config->cluster->num_replicas,
 			sizeof(*state->gst_vector));
+	state->messages = message_pool_new();
 	return state;
 }
 
@@ -61,7 +63,7 @@ static void grv_client_get_request(client_state_t *client, gr_key key)
 {
 	client_state_grv_t *state = client_protocol_state(client);
 	lpid_t server_lpid = client_lpid_for_key(state->config, key);
-	grv_get_request_t *request = grv_get_request_new(
+	grv_get_request_t *request = grv_get_request_pooled(state->messages,
 			state->config->cluster->num_replicas);
 	request->client_lpid = state->config->lpid;
 	request->proxy_lpid = NO_PROXY_LPID;
@@ -71,14 +73,13 @@ static void grv_client_get_request(client_state_t *client, gr_key key)
 			state->config->cluster->num_replicas * sizeof(*state->gst_vector));
 	client_begin_request(client);
 	client_send(client, server_lpid, GRV_GET_REQUEST, &request->message);
-	free(request);
 }
 
 static void grv_client_put_request(client_state_t *client, gr_key key, gr_value value)
 {
 	client_state_grv_t *state = client_protocol_state(client);
 	lpid_t server_lpid = client_lpid_for_key(state->config, key);
-	grv_put_request_t *request = grv_put_request_new(
+	grv_put_request_t *request = grv_put_request_pooled(state->messages,
 			state->config->cluster->num_replicas);
 	request->client_lpid = state->config->lpid;
 	request->proxy_lpid = NO_PROXY_LPID;
@@ -87,14 +88,13 @@ static void grv_client_put_request(client_state_t *client, gr_key key, gr_value
 	max_gst_and_dependency_vector(grv_put_request_dependency_vector(request), state);
 	client_begin_request(client);
 	client_send(client, server_lpid, GRV_PUT_REQUEST, &request->message);
-	free(request);
 }
 
 static void grv_client_rotx_request(client_state_t *client, gr_key *keys,
 		unsigned int num_keys)
 {
 	client_state_grv_t *state = client_protocol_state(client);
-	grv_rotx_request_t *request = grv_rotx_request_new(
+	grv_rotx_request_t *request = grv_rotx_request_pooled(state->messages,
 			num_keys, state->config->cluster->num_replicas);
 	request->client_lpid = state->config->lpid;
 	request->dependency_time = state->dependency_vector[state->config->replica];
@@ -104,7 +104,6 @@ static void grv_client_rotx_request(client_state_t *client, gr_key *keys,
 	lpid_t server_lpid = lpid_of_any_partition(client);
 	client_begin_request(client);
 	client_send(client, server_lpid, GRV_ROTX_REQUEST, &request->message);
-	free(request);
 }
 
 static void get_response(client_state_t *client, grv_get_response_t *response)
@@ -9,7 +9,8 @@
 	(replica * cluster->num_partitions + partition)
 
 cluster_config_t *cluster_new(allocator alloc, unsigned int num_replicas,
-		unsigned int num_partitions, unsigned int num_keys, double clock_skew)
+		unsigned int num_partitions, unsigned int num_keys, double clock_skew,
+		int dense_store, unsigned int inline_versions)
 {
 	cluster_config_t *cluster = alloc(sizeof(cluster_config_t));
 	cluster->num_replicas = num_replicas;
@@ -20,6 +21,8 @@ cluster_config_t *cluster_new(allocator alloc, unsigned int num_replicas,
 	cluster->key_max = num_keys;
 	assert(clock_skew >= 0);
 	cluster->clock_skew = clock_skew;
+	cluster->dense_store = dense_store;
+	cluster->inline_versions = inline_versions;
 	return cluster;
 }
 
@@ -42,6 +45,16 @@ partition_t partition_for_key(cluster_config_t *cluster, gr_key key)
 	return (partition_t) (key % cluster->num_partitions);
 }
 
+gr_key cluster_num_keys_on_partition(cluster_config_t *cluster,
+		partition_t partition)
+{
+	assert(partition < cluster->num_partitions);
+	assert(cluster->key_min == 0);
+	// Keys range from 0 to key_max included.
+	if (partition > cluster->key_max) return 0;
+	return (cluster->key_max - partition) / cluster->num_partitions + 1;
+}
+
 gr_key cluster_random_key(cluster_config_t *cluster)
 {
 	if (cluster->key_max == UINT_MAX) {
@@ -16,15 +16,20 @@ typedef struct cluster_config {
 	gr_key key_min;
 	gr_key key_max;
 	double clock_skew;
+	int dense_store; // Directly index the keys of each partition, see store.h
+	unsigned int inline_versions; // Latest versions stored together per key
 } cluster_config_t;
 
 cluster_config_t *cluster_new(allocator alloc, unsigned int num_replicas,
-		unsigned int num_partitions, unsigned int num_keys, double clock_skew);
+		unsigned int num_partitions, unsigned int num_keys, double clock_skew,
+		int dense_store, unsigned int inline_versions);
 void cluster_set_lpid(cluster_config_t *cluster, replica_t replica,
 		partition_t partition, lpid_t lpid);
 lpid_t cluster_get_lpid(cluster_config_t *cluster, replica_t replica,
 		partition_t partition);
 partition_t partition_for_key(cluster_config_t *cluster, gr_key key);
+gr_key cluster_num_keys_on_partition(cluster_config_t *cluster,
+		partition_t partition);
 gr_key cluster_random_key(cluster_config_t *cluster);
 gr_key cluster_random_key_on_partition(cluster_config_t *cluster,
 		partition_t partition);
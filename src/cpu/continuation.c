@@ -0,0 +1,68 @@
+#include "cpu/continuation.h"
+#include "common.h"
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+void cpu_continuations_init(cpu_continuations_t *table)
+{
+	table->num_slots = 0;
+	table->allocated_slots = 0;
+	table->slots = NULL;
+	table->num_free = 0;
+	table->allocated_free = 0;
+	table->free_slots = NULL;
+}
+
+static unsigned int get_free_slot(cpu_continuations_t *table)
+{
+	if (table->num_free > 0) {
+		return table->free_slots[--table->num_free];
+	}
+	cpu_continuation_t slot = {
+		.size = 0,
+		.allocated_size = 0,
+		.data = NULL,
+	};
+	parray_push(&table->slots, &table->num_slots, &table->allocated_slots,
+			slot);
+	return table->num_slots - 1;
+}
+
+unsigned int cpu_continuation_put(cpu_continuations_t *table,
+		const void *data, size_t size)
+{
+	if (size == 0) return CPU_NO_CONTINUATION;
+	unsigned int handle = get_free_slot(table);
+	cpu_continuation_t *slot = &table->slots[handle];
+	if (slot->allocated_size < size) {
+		free(slot->data);
+		slot->data = malloc(size);
+		slot->allocated_size = size;
+	}
+	memcpy(slot->data, data, size);
+	slot->size = size;
+	return handle;
+}
+
+void *cpu_continuation_data(cpu_continuations_t *table, unsigned int handle)
+{
+	if (handle == CPU_NO_CONTINUATION) return NULL;
+	assert(handle < table->num_slots);
+	return table->slots[handle].data;
+}
+
+size_t cpu_continuation_size(cpu_continuations_t *table, unsigned int handle)
+{
+	if (handle == CPU_NO_CONTINUATION) return 0;
+	assert(handle < table->num_slots);
+	return table->slots[handle].size;
+}
+
+void cpu_continuation_release(cpu_continuations_t *table, unsigned int handle)
+{
+	if (handle == CPU_NO_CONTINUATION) return;
+	assert(handle < table->num_slots);
+	parray_push(&table->free_slots, &table->num_free, &table->allocated_free,
+			handle);
+}
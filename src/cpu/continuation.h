@@ -0,0 +1,51 @@
+/* continuation.{c,h}
+ *
+ * Table holding the payloads of the continuations of lock operations until
+ * they are processed. The scheduled and queued lock messages only carry the
+ * handle of their payload, which is thus copied once whatever the number of
+ * times the message is scheduled or queued.
+ *
+ * The buffers of released slots are reused by the next continuations so that
+ * the table does not allocate memory once it reached its usual size.
+ */
+
+#ifndef cpu_continuation_h
+#define cpu_continuation_h
+
+#include <stddef.h>
+
+/* Handle of the continuations without payload */
+#define CPU_NO_CONTINUATION ((unsigned int) -1)
+
+typedef struct cpu_continuation cpu_continuation_t;
+typedef struct cpu_continuations cpu_continuations_t;
+
+struct cpu_continuation {
+	size_t size;
+	size_t allocated_size;
+	void *data;
+};
+
+struct cpu_continuations {
+	unsigned int num_slots;
+	unsigned int allocated_slots;
+	cpu_continuation_t *slots;
+	unsigned int num_free;
+	unsigned int allocated_free;
+	unsigned int *free_slots; // Stack of released slots
+};
+
+void cpu_continuations_init(cpu_continuations_t *table);
+
+/* Copy the given payload in a slot of the table and return its handle. */
+unsigned int cpu_continuation_put(cpu_continuations_t *table,
+		const void *data, size_t size);
+
+/* Return the payload of the given handle, which stays valid until the handle
+ * is released even if other payloads are put in the table. */
+void *cpu_continuation_data(cpu_continuations_t *table, unsigned int handle);
+size_t cpu_continuation_size(cpu_continuations_t *table, unsigned int handle);
+
+void cpu_continuation_release(cpu_continuations_t *table, unsigned int handle);
+
+#endif
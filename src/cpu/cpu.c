@@ -47,7 +47,7 @@ static void cpu_process_event(lpid_t lpid, simtime_t now, unsigned int event_typ
 				|| cpu_rwlock_process_event(state, event_type, data);
 			if (!handled) {
 				if (cpu_busy(state)) {
-					cpu_list_item_t *item = cpu_list_item_new(
+					cpu_list_item_t *item = cpu_list_item_new(&state->item_pool,
 							event_type, data, data_size);
 					cpu_list_push(&state->queue, item);
 				} else {
@@ -105,6 +105,8 @@ cpu_state_t *cpu_setup(lpid_t lpid, simtime_t now, void *lp_state,
 	state->stats = cpu_stats_new();
 	state->lp_state = lp_state;
 	cpu_list_init(&state->queue);
+	cpu_list_pool_init(&state->item_pool);
+	cpu_continuations_init(&state->continuations);
 	state->cores = cores;
 	state->busy_cores = 0;
 	state->elapsed_time = 0;
@@ -1,6 +1,8 @@
 #include "cpu/list.h"
 #include <assert.h>
 
+#define ITEMS_PER_SLAB 32
+
 void cpu_list_init(cpu_list_t *list)
 {
 	list->head = NULL;
@@ -54,26 +56,46 @@ void cpu_list_unshift(cpu_list_t *list, cpu_list_item_t *item)
 	list->size++;
 }
 
-cpu_list_item_t *cpu_list_item_new(unsigned int event_type,
-		void *data, size_t data_size)
+void cpu_list_pool_init(cpu_list_pool_t *pool)
+{
+	pool->free_items = NULL;
+}
+
+static cpu_list_item_t *pool_get(cpu_list_pool_t *pool)
 {
-	cpu_list_item_t *item = malloc(sizeof(cpu_list_item_t));
+	if (pool->free_items == NULL) {
+		cpu_list_item_t *slab = malloc(ITEMS_PER_SLAB * sizeof(cpu_list_item_t));
+		for (unsigned int i = 0; i < ITEMS_PER_SLAB; ++i) {
+			slab[i].next = pool->free_items;
+			pool->free_items = &slab[i];
+		}
+	}
+	cpu_list_item_t *item = pool->free_items;
+	pool->free_items = item->next;
+	return item;
+}
+
+cpu_list_item_t *cpu_list_item_new(cpu_list_pool_t *pool,
+		unsigned int event_type, void *data, size_t data_size)
+{
+	cpu_list_item_t *item = pool_get(pool);
 	item->event_type = event_type;
-	item->data = malloc(data_size);
+	if (data_size <= CPU_LIST_ITEM_INLINE_SIZE) {
+		item->data = item->inline_data;
+	} else {
+		item->data = malloc(data_size);
+	}
 	memcpy(item->data, data, data_size);
 	item->data_size = data_size;
 	item->next = NULL;
 	return item;
 }
 
-cpu_list_item_t *cpu_list_item_new_from_lock_msg(cpu_lock_msg_t *msg)
+void cpu_list_item_free(cpu_list_pool_t *pool, cpu_list_item_t *item)
 {
-	return cpu_list_item_new(msg->event_type, cpu_lock_msg_data(msg),
-			msg->data_size);
-}
-
-void cpu_list_item_free(cpu_list_item_t *item)
-{
-	free(item->data);
-	free(item);
+	if (item->data != item->inline_data) {
+		free(item->data);
+	}
+	item->next = pool->free_items;
+	pool->free_items = item;
 }
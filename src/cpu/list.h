@@ -2,15 +2,28 @@
 #define cpu_list_h
 
 #include "cpu/messages.h"
+#include <stddef.h>
+
+/* Payloads up to this size are stored in the item itself */
+#define CPU_LIST_ITEM_INLINE_SIZE 96
 
 typedef struct cpu_list cpu_list_t;
 typedef struct cpu_list_item cpu_list_item_t;
+typedef struct cpu_list_pool cpu_list_pool_t;
 
 struct cpu_list_item {
 	unsigned int event_type;
 	size_t data_size;
 	void *data;
 	struct cpu_list_item *next;
+	_Alignas(max_align_t) unsigned char inline_data[CPU_LIST_ITEM_INLINE_SIZE];
+};
+
+/* Items are allocated by slabs and recycled through a free list so that
+ * queueing events does not allocate memory once the queues reached their
+ * usual size. */
+struct cpu_list_pool {
+	cpu_list_item_t *free_items;
 };
 
 struct cpu_list {
@@ -35,10 +48,10 @@ void cpu_list_unshift(cpu_list_t *list, cpu_list_item_t *item);
 /* Remove an item from the tail, currently not needed */
 //cpu_list_item_t *cpu_list_pop(cpu_list_t* list);
 
-cpu_list_item_t *cpu_list_item_new(unsigned int event_type, void *data,
-		size_t data_size);
-cpu_list_item_t *cpu_list_item_new_from_lock_msg(cpu_lock_msg_t *msg);
-void cpu_list_item_free(cpu_list_item_t *item);
+void cpu_list_pool_init(cpu_list_pool_t *pool);
+cpu_list_item_t *cpu_list_item_new(cpu_list_pool_t *pool,
+		unsigned int event_type, void *data, size_t data_size);
+void cpu_list_item_free(cpu_list_pool_t *pool, cpu_list_item_t *item);
 
 
 #endif
@@ -10,11 +10,29 @@
 
 static DEFINE_TIMING_FUNC(lock_time)
 
+/* When the "inline_uncontended_locks" application parameter is set, a lock
+ * that nobody holds or waits for is acquired and released without scheduling
+ * any event: the continuations are processed right away as if they were
+ * executed at the time they would have been in a scheduled event. The
+ * critical section is then recorded as a reservation of the lock until the
+ * time it is released. Acquisitions made during a reservation fall back to
+ * the queued events and wait for the end of the reservation.
+ *
+ * The continuations then change the state of the LP before events with an
+ * earlier time are processed. This is only done with a single core, whose
+ * next events are processed after the end of the current one anyway. */
 struct cpu_lock {
 	int locked;
 	cpu_list_t *queue;
+	unsigned int waiting; // Acquisitions scheduled or queued, but not granted
+	simtime_t reserved_until;
 };
 
+static int can_inline(cpu_state_t *state)
+{
+	return app_params.inline_uncontended_locks && state->cores == 1;
+}
+
 static cpu_lock_t *get_lock(cpu_state_t *state, unsigned int id)
 {
 	assert(id < state->num_locks);
@@ -26,6 +44,8 @@ cpu_lock_id_t cpu_lock_new(cpu_state_t *state) {
 	cpu_lock_t lock = {
 		.locked = 0,
 		.queue = cpu_list_new(),
+		.waiting = 0,
+		.reserved_until = 0,
 	};
 	array_push(&state->locks, &state->num_locks, lock);
 	return id;
@@ -36,8 +56,18 @@ void cpu_lock_lock(cpu_state_t *state, cpu_lock_id_t id,
 {
 	assert(event_type != 0);
 	cpu_add_time(state, lock_time());
-	cpu_schedule_lock_msg(state, CPU_LOCK_LOCK, id.id,
-			event_type, data, data_size);
+	cpu_lock_t *lock = get_lock(state, id.id);
+	if (can_inline(state) && !lock->locked
+			&& lock->waiting == 0
+			&& lock->reserved_until <= state->now + state->elapsed_time) {
+		cpu_processing_continues_in_scheduled_event(state);
+		lock->locked = 1;
+		cpu_process_inline(state, event_type, data, data_size);
+	} else {
+		++lock->waiting;
+		cpu_schedule_lock_msg(state, CPU_LOCK_LOCK, id.id,
+				event_type, data, data_size);
+	}
 }
 
 static void on_lock_lock(cpu_state_t *state, cpu_lock_msg_t *msg)
@@ -45,24 +75,39 @@ static void on_lock_lock(cpu_state_t *state, cpu_lock_msg_t *msg)
 	cpu_add_time(state, lock_time());
 	cpu_busy_cores_dec(state);
 	cpu_lock_t *lock = get_lock(state, msg->lock_id);
-	if (lock->locked) {
-		cpu_list_item_t *item = cpu_list_item_new(CPU_LOCK_LOCK, msg,
-				cpu_lock_msg_size(msg));
+	if (lock->locked || lock->reserved_until > state->now) {
+		if (!lock->locked && cpu_list_empty(lock->queue)) {
+			cpu_schedule_event(state, lock->reserved_until - state->now,
+					CPU_LOCK_RESERVATION_END, &msg->lock_id,
+					sizeof(msg->lock_id));
+		}
+		cpu_list_item_t *item = cpu_list_item_new(&state->item_pool,
+				CPU_LOCK_LOCK, msg, sizeof(*msg));
 		cpu_list_push(lock->queue, item);
 		cpu_schedule_event(state, 0, CPU_EVENT, NULL, 0);
 	} else {
+		assert(lock->waiting > 0);
+		--lock->waiting;
 		lock->locked = 1;
-		cpu_process(state, msg->event_type, cpu_lock_msg_data(msg), msg->data_size);
+		cpu_process_lock_msg(state, msg);
 	}
 }
 
 void cpu_lock_unlock(cpu_state_t *state, cpu_lock_id_t id,
 		unsigned int event_type, void *data, size_t data_size)
 {
-	assert(get_lock(state, id.id)->locked);
+	cpu_lock_t *lock = get_lock(state, id.id);
+	assert(lock->locked);
 	cpu_add_time(state, lock_time());
-	cpu_schedule_lock_msg(state, CPU_LOCK_UNLOCK, id.id,
-			event_type, data, data_size);
+	if (can_inline(state) && cpu_list_empty(lock->queue)) {
+		cpu_processing_continues_in_scheduled_event(state);
+		lock->locked = 0;
+		lock->reserved_until = state->now + state->elapsed_time;
+		cpu_process_inline(state, event_type, data, data_size);
+	} else {
+		cpu_schedule_lock_msg(state, CPU_LOCK_UNLOCK, id.id,
+				event_type, data, data_size);
+	}
 }
 
 static void on_lock_unlock(cpu_state_t *state, cpu_lock_msg_t *msg)
@@ -76,7 +121,21 @@ static void on_lock_unlock(cpu_state_t *state, cpu_lock_msg_t *msg)
 		cpu_list_item_t *item = cpu_list_shift(lock->queue);
 		cpu_list_unshift(&state->queue, item);
 	}
-	cpu_process(state, msg->event_type, cpu_lock_msg_data(msg), msg->data_size);
+	cpu_process_lock_msg(state, msg);
+}
+
+static void on_lock_reservation_end(cpu_state_t *state, unsigned int *lock_id)
+{
+	cpu_lock_t *lock = get_lock(state, *lock_id);
+	// The lock may have been taken by an acquisition which was not queued
+	if (!lock->locked && !cpu_list_empty(lock->queue)) {
+		cpu_list_item_t *item = cpu_list_shift(lock->queue);
+		cpu_list_unshift(&state->queue, item);
+		// Otherwise the next core freed picks it up
+		if (!cpu_busy(state)) {
+			cpu_process_next_in_queue(state);
+		}
+	}
 }
 
 int cpu_lock_process_event(cpu_state_t *state, unsigned int event_type,
@@ -89,6 +148,9 @@ int cpu_lock_process_event(cpu_state_t *state, unsigned int event_type,
 		case CPU_LOCK_UNLOCK:
 			on_lock_unlock(state, data);
 			break;
+		case CPU_LOCK_RESERVATION_END:
+			on_lock_reservation_end(state, data);
+			break;
 		default:
 			return 0;
 	}
@@ -53,8 +53,8 @@ static void on_rwlock_read_lock(cpu_state_t *state, cpu_lock_msg_t *msg)
 	cpu_rwlock_t *rwlock = get_rwlock(state, msg->lock_id);
 	if (rwlock->write_locked && rwlock->counter == 0) {
 		assert(msg->event_type != 0);
-		cpu_list_item_t *item = cpu_list_item_new(CPU_RWLOCK_READ_LOCK,
-				msg, cpu_lock_msg_size(msg));
+		cpu_list_item_t *item = cpu_list_item_new(&state->item_pool,
+				CPU_RWLOCK_READ_LOCK, msg, sizeof(*msg));
 		cpu_list_push(rwlock->queue, item);
 		cpu_schedule_event(state, 0, CPU_EVENT, NULL, 0);
 	} else {
@@ -62,7 +62,7 @@ static void on_rwlock_read_lock(cpu_state_t *state, cpu_lock_msg_t *msg)
 		if (rwlock->counter == 1) {
 			rwlock->write_locked = 1;
 		}
-		cpu_process(state, msg->event_type, cpu_lock_msg_data(msg), msg->data_size);
+		cpu_process_lock_msg(state, msg);
 	}
 }
 
@@ -89,7 +89,7 @@ static void on_rwlock_read_unlock(cpu_state_t *state, cpu_lock_msg_t *msg)
 			cpu_list_unshift(&state->queue, item);
 		}
 	}
-	cpu_process(state, msg->event_type, cpu_lock_msg_data(msg), msg->data_size);
+	cpu_process_lock_msg(state, msg);
 }
 
 void cpu_rwlock_write_lock(cpu_state_t *state, cpu_rwlock_id_t id,
@@ -106,13 +106,13 @@ static void on_rwlock_write_lock(cpu_state_t *state, cpu_lock_msg_t *msg)
 	cpu_busy_cores_dec(state);
 	cpu_rwlock_t *rwlock = get_rwlock(state, msg->lock_id);
 	if (rwlock->write_locked) {
-		cpu_list_item_t *item = cpu_list_item_new(CPU_RWLOCK_WRITE_LOCK,
-				msg, cpu_lock_msg_size(msg));
+		cpu_list_item_t *item = cpu_list_item_new(&state->item_pool,
+				CPU_RWLOCK_WRITE_LOCK, msg, sizeof(*msg));
 		cpu_list_push(rwlock->queue, item);
 		cpu_schedule_event(state, 0, CPU_EVENT, NULL, 0);
 	} else {
 		rwlock->write_locked = 1;
-		cpu_process(state, msg->event_type, cpu_lock_msg_data(msg), msg->data_size);
+		cpu_process_lock_msg(state, msg);
 	}
 }
 
@@ -137,7 +137,7 @@ static void on_rwlock_write_unlock(cpu_state_t *state, cpu_lock_msg_t *msg)
 		cpu_list_item_t *item = cpu_list_shift(rwlock->queue);
 		cpu_list_unshift(&state->queue, item);
 	}
-	cpu_process(state, msg->event_type, cpu_lock_msg_data(msg), msg->data_size);
+	cpu_process_lock_msg(state, msg);
 }
 
 int cpu_rwlock_write_locked(cpu_state_t *state, cpu_rwlock_id_t id)
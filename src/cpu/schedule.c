@@ -1,11 +1,12 @@
 #include "cpu/schedule.h"
+#include "cpu/continuation.h"
 #include "cpu/messages.h"
 #include "cpu/list.h"
-#include "cpu/schedule.h"
 #include "cpu/state.h"
 #include "event.h"
 #include <assert.h>
 #include <limits.h>
+#include <math.h>
 
 void cpu_process(cpu_state_t *state,
 		unsigned int type, void *data, size_t data_size)
@@ -39,12 +40,35 @@ void cpu_process(cpu_state_t *state,
 	}
 }
 
+void cpu_process_inline(cpu_state_t *state,
+		unsigned int type, void *data, size_t data_size)
+{
+	// The core is freed at the end of the event being processed
+	if (type == CPU_NO_EVENT) return;
+
+	simtime_t now = state->now;
+	simtime_t elapsed_time = state->elapsed_time;
+	state->now = now + elapsed_time;
+	state->elapsed_time = 0;
+	state->continues_in_scheduled_event = 0;
+	state->process_event(state->lpid, state->now, type, data, data_size,
+			state->lp_state);
+	simtime_t end = state->now + state->elapsed_time;
+	state->now = now;
+	state->elapsed_time += elapsed_time;
+	// Rounding must not free the core before the end of the continuation
+	while (now + state->elapsed_time < end) {
+		state->elapsed_time = nextafter(state->elapsed_time, INFINITY);
+	}
+	state->continues_in_scheduled_event = 1;
+}
+
 void cpu_process_next_in_queue(cpu_state_t *state)
 {
 	cpu_list_item_t *item = cpu_list_shift(&state->queue);
 	if (item != NULL) {
 		cpu_process(state, item->event_type, item->data, item->data_size);
-		cpu_list_item_free(item);
+		cpu_list_item_free(&state->item_pool, item);
 	}
 }
 
@@ -61,8 +85,21 @@ void cpu_schedule_lock_msg(cpu_state_t *state, unsigned int cpu_event_type,
 {
 	cpu_processing_continues_in_scheduled_event(state);
 	state->free_core_after_event_processing = 0;
-	size_t size;
-	cpu_lock_msg_t *msg = cpu_lock_msg_new(&size, id, event_type, data, data_size);
-	cpu_schedule_event(state, state->elapsed_time, cpu_event_type, msg, size);
-	free(msg);
+	cpu_lock_msg_t msg = {
+		.lock_id = id,
+		.event_type = event_type,
+		.continuation = cpu_continuation_put(&state->continuations, data,
+				data_size),
+	};
+	cpu_schedule_event(state, state->elapsed_time, cpu_event_type, &msg,
+			sizeof(msg));
+}
+
+void cpu_process_lock_msg(cpu_state_t *state, cpu_lock_msg_t *msg)
+{
+	unsigned int continuation = msg->continuation;
+	cpu_process(state, msg->event_type,
+			cpu_continuation_data(&state->continuations, continuation),
+			cpu_continuation_size(&state->continuations, continuation));
+	cpu_continuation_release(&state->continuations, continuation);
 }
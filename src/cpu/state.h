@@ -1,6 +1,7 @@
 #ifndef cpu_state_h
 #define cpu_state_h
 
+#include "cpu/continuation.h"
 #include "cpu/list.h"
 #include "cpu/lock.h"
 #include "cpu/rwlock.h"
@@ -11,6 +12,8 @@ struct cpu_state {
 	int (*on_gvt)(lpid_t, void*);
 	void *lp_state;
 	cpu_list_t queue;
+	cpu_list_pool_t item_pool;
+	cpu_continuations_t continuations;
 	unsigned int cores;
 	unsigned int busy_cores;
 	simtime_t elapsed_time;
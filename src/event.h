@@ -20,6 +20,7 @@ const char* event_name(event_type_t type);
 	FUNC(CPU_NO_EVENT) \
 	FUNC(CPU_LOCK_LOCK) \
 	FUNC(CPU_LOCK_UNLOCK) \
+	FUNC(CPU_LOCK_RESERVATION_END) \
 	FUNC(CPU_RWLOCK_READ_LOCK) \
 	FUNC(CPU_RWLOCK_READ_UNLOCK) \
 	FUNC(CPU_RWLOCK_WRITE_LOCK) \
@@ -37,10 +38,18 @@ const char* event_name(event_type_t type);
 	FUNC(GR_REPLICA_UPDATE) \
 	FUNC(GR_REPLICA_UPDATE_LOCKED) \
 	FUNC(GR_REPLICA_UPDATE_UNLOCKED) \
+	FUNC(GR_REPLICA_UPDATE_PARALLEL_LOCKED) \
+	FUNC(GR_REPLICA_UPDATE_PARALLEL_UNLOCKED) \
+	FUNC(GR_REPLICA_UPDATE_BATCH) \
+	FUNC(GR_REPLICA_UPDATE_BATCH_LOCKED) \
+	FUNC(GR_REPLICA_UPDATE_BATCH_UNLOCKED) \
+	FUNC(GR_REPLICATION_BATCH_TIMEOUT) \
 	FUNC(GR_LST_FROM_LEAF) \
 	FUNC(GR_LST_FROM_LEAF_ROOT_LOCKED) \
 	FUNC(GR_LST_FROM_LEAF_ROOT_UNLOCKED) \
 	FUNC(GR_START_GST_COMPUTATION) \
+	FUNC(GR_LST_BROADCAST) \
+	FUNC(GR_LST_BROADCAST_LOCKED) \
 	FUNC(GR_GST_FROM_ROOT) \
 	FUNC(GR_GST_FROM_ROOT_LOCKED) \
 	FUNC(GR_GST_FROM_ROOT_UNLOCKED) \
@@ -75,6 +84,10 @@ const char* event_name(event_type_t type);
 	FUNC(GRV_REPLICA_UPDATE) \
 	FUNC(GRV_REPLICA_UPDATE_VV_LOCKED) \
 	FUNC(GRV_REPLICA_UPDATE_VV_UNLOCKED) \
+	FUNC(GRV_REPLICA_UPDATE_BATCH) \
+	FUNC(GRV_REPLICA_UPDATE_BATCH_VV_LOCKED) \
+	FUNC(GRV_REPLICA_UPDATE_BATCH_VV_UNLOCKED) \
+	FUNC(GRV_REPLICATION_BATCH_TIMEOUT) \
 	FUNC(GRV_SLICE_REQUEST) \
 	FUNC(GRV_SLICE_REQUEST_LOCKED) \
 	FUNC(GRV_SLICE_REQUEST_UNLOCKED) \
@@ -92,6 +105,8 @@ const char* event_name(event_type_t type);
 	FUNC(GRV_LST_FROM_LEAF) \
 	FUNC(GRV_LST_FROM_LEAF_ROOT_LOCKED) \
 	FUNC(GRV_LST_FROM_LEAF_ROOT_UNLOCKED) \
+	FUNC(GRV_LST_BROADCAST) \
+	FUNC(GRV_LST_BROADCAST_LOCKED) \
 	FUNC(GRV_GST_FROM_ROOT) \
 	FUNC(GRV_GST_FROM_ROOT_LOCKED) \
 	FUNC(GRV_GST_FROM_ROOT_UNLOCKED) \
@@ -0,0 +1,155 @@
+#include "histogram.h"
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+
+#define LAST_BUCKET (HISTOGRAM_NUM_BUCKETS - 1)
+
+void histogram_init(histogram_t *histogram)
+{
+	histogram->count = 0;
+	histogram->sum = 0;
+	histogram->mean = 0;
+	histogram->m2 = 0;
+	histogram->min = 0;
+	histogram->max = 0;
+	for (unsigned int i = 0; i < HISTOGRAM_NUM_BUCKETS; ++i) {
+		histogram->buckets[i] = 0;
+	}
+}
+
+histogram_t *histogram_new(void)
+{
+	histogram_t *histogram = malloc(sizeof(histogram_t));
+	histogram_init(histogram);
+	return histogram;
+}
+
+static unsigned int bucket_index(double value)
+{
+	if (!(value >= ldexp(0.5, HISTOGRAM_MIN_EXPONENT))) return 0;
+	int exponent;
+	double mantissa = frexp(value, &exponent); // In [0.5, 1)
+	if (exponent > HISTOGRAM_MAX_EXPONENT) return LAST_BUCKET;
+	unsigned int sub_bucket = (unsigned int)
+		((mantissa - 0.5) * 2 * HISTOGRAM_SUB_BUCKETS);
+	return 1 + (unsigned int) (exponent - HISTOGRAM_MIN_EXPONENT)
+		* HISTOGRAM_SUB_BUCKETS + sub_bucket;
+}
+
+static double bucket_lower_bound(unsigned int index)
+{
+	if (index == 0) return 0;
+	if (index == LAST_BUCKET) return ldexp(1, HISTOGRAM_MAX_EXPONENT);
+	unsigned int sub_bucket = (index - 1) % HISTOGRAM_SUB_BUCKETS;
+	int exponent = HISTOGRAM_MIN_EXPONENT
+		+ (int) ((index - 1) / HISTOGRAM_SUB_BUCKETS);
+	return ldexp(0.5 + sub_bucket / (2.0 * HISTOGRAM_SUB_BUCKETS), exponent);
+}
+
+void histogram_add(histogram_t *histogram, double value)
+{
+	if (histogram->count == 0 || value < histogram->min) {
+		histogram->min = value;
+	}
+	if (histogram->count == 0 || value > histogram->max) {
+		histogram->max = value;
+	}
+	++histogram->count;
+	histogram->sum += value;
+	double delta = value - histogram->mean;
+	histogram->mean += delta / (double) histogram->count;
+	histogram->m2 += delta * (value - histogram->mean);
+	++histogram->buckets[bucket_index(value)];
+}
+
+void histogram_merge(histogram_t *histogram, const histogram_t *other)
+{
+	if (other->count == 0) return;
+	if (histogram->count == 0 || other->min < histogram->min) {
+		histogram->min = other->min;
+	}
+	if (histogram->count == 0 || other->max > histogram->max) {
+		histogram->max = other->max;
+	}
+	double count = (double) (histogram->count + other->count);
+	double delta = other->mean - histogram->mean;
+	histogram->mean += delta * (double) other->count / count;
+	histogram->m2 += other->m2 + delta * delta
+		* (double) histogram->count * (double) other->count / count;
+	histogram->count += other->count;
+	histogram->sum += other->sum;
+	for (unsigned int i = 0; i < HISTOGRAM_NUM_BUCKETS; ++i) {
+		histogram->buckets[i] += other->buckets[i];
+	}
+}
+
+double histogram_average(const histogram_t *histogram)
+{
+	if (histogram->count == 0) return 0;
+	return histogram->sum / (double) histogram->count;
+}
+
+double histogram_variance(const histogram_t *histogram)
+{
+	if (histogram->count < 2) return 0;
+	return histogram->m2 / (double) (histogram->count - 1);
+}
+
+double histogram_quantile(const histogram_t *histogram, double q)
+{
+	assert(q >= 0 && q <= 1);
+	if (histogram->count == 0) return 0;
+	uint64_t rank = (uint64_t) ceil(q * (double) histogram->count);
+	if (rank == 0) rank = 1;
+	uint64_t seen = 0;
+	unsigned int i = 0;
+	for (; i < LAST_BUCKET; ++i) {
+		seen += histogram->buckets[i];
+		if (seen >= rank) break;
+	}
+	if (i == 0) return histogram->min;
+	if (i == LAST_BUCKET) return histogram->max;
+	double value = (bucket_lower_bound(i) + bucket_lower_bound(i + 1)) / 2;
+	// The middle of the bucket may be outside of the samples' range
+	if (value < histogram->min) return histogram->min;
+	if (value > histogram->max) return histogram->max;
+	return value;
+}
+
+void histogram_output(const histogram_t *histogram, struct json_object *obj,
+		int with_buckets)
+{
+	assert(histogram->count <= INT64_MAX);
+	json_object_object_add(obj, "sample size",
+			json_object_new_int64((int64_t) histogram->count));
+	json_object_object_add(obj, "average",
+			json_object_new_double(histogram_average(histogram)));
+	json_object_object_add(obj, "standard deviation",
+			json_object_new_double(sqrt(histogram_variance(histogram))));
+	json_object_object_add(obj, "min", json_object_new_double(histogram->min));
+	json_object_object_add(obj, "max", json_object_new_double(histogram->max));
+
+	struct json_object *percentiles = json_object_new_object();
+	const char *names[] = {"50", "90", "99", "99.9"};
+	const double quantiles[] = {0.5, 0.9, 0.99, 0.999};
+	for (unsigned int i = 0; i < sizeof(quantiles) / sizeof(*quantiles); ++i) {
+		json_object_object_add(percentiles, names[i], json_object_new_double(
+					histogram_quantile(histogram, quantiles[i])));
+	}
+	json_object_object_add(obj, "percentiles", percentiles);
+
+	if (!with_buckets) return;
+	struct json_object *buckets = json_object_new_array();
+	for (unsigned int i = 0; i < HISTOGRAM_NUM_BUCKETS; ++i) {
+		if (histogram->buckets[i] == 0) continue;
+		assert(histogram->buckets[i] <= INT64_MAX);
+		struct json_object *bucket = json_object_new_array();
+		json_object_array_add(bucket,
+				json_object_new_double(bucket_lower_bound(i)));
+		json_object_array_add(bucket,
+				json_object_new_int64((int64_t) histogram->buckets[i]));
+		json_object_array_add(buckets, bucket);
+	}
+	json_object_object_add(obj, "histogram", buckets);
+}
@@ -0,0 +1,66 @@
+/* histogram.{c,h}
+ *
+ * Constant-memory accumulator of samples. It keeps the count, sum, mean and
+ * variance (Welford's algorithm) and a histogram with logarithmic buckets
+ * from which percentiles are estimated.
+ *
+ * Each power of two is split in HISTOGRAM_SUB_BUCKETS buckets of equal width,
+ * so that a percentile is off by at most 1 / (2 * HISTOGRAM_SUB_BUCKETS) of
+ * its value. The buckets cover 2^HISTOGRAM_MIN_EXPONENT / 2 (about 1 ns) up
+ * to 2^HISTOGRAM_MAX_EXPONENT (about 4.5 hours). Smaller samples, including
+ * zero and negative ones, are counted in the first bucket and greater ones
+ * in the last one.
+ *
+ * Histograms with the same layout are merged by adding their bucket counts,
+ * which histogram_merge() does and which can be done on the exported
+ * buckets.
+ */
+
+#ifndef histogram_h
+#define histogram_h
+
+#include <json.h>
+#include <stdint.h>
+
+#define HISTOGRAM_SUB_BUCKETS 16
+#define HISTOGRAM_MIN_EXPONENT -29
+#define HISTOGRAM_MAX_EXPONENT 14
+#define HISTOGRAM_NUM_BUCKETS (2 + HISTOGRAM_SUB_BUCKETS \
+		* (HISTOGRAM_MAX_EXPONENT - HISTOGRAM_MIN_EXPONENT + 1))
+
+typedef struct histogram histogram_t;
+
+struct histogram {
+	uint64_t count;
+	double sum;
+	double mean;
+	double m2; // Sum of the squared differences to the mean
+	double min;
+	double max;
+	uint64_t buckets[HISTOGRAM_NUM_BUCKETS];
+};
+
+void histogram_init(histogram_t *histogram);
+histogram_t *histogram_new(void);
+void histogram_add(histogram_t *histogram, double value);
+
+/* Add the samples of other to histogram. */
+void histogram_merge(histogram_t *histogram, const histogram_t *other);
+
+/* The average is computed from the sum of the samples, as when the samples
+ * are stored and averaged at the end. Return 0 without samples. */
+double histogram_average(const histogram_t *histogram);
+double histogram_variance(const histogram_t *histogram);
+
+/* Return an estimation of the q-quantile with 0 <= q <= 1, 0 without
+ * samples. */
+double histogram_quantile(const histogram_t *histogram, double q);
+
+/* Add the "sample size", "average", "standard deviation", "min", "max" and
+ * "percentiles" of the samples to the given JSON object. When with_buckets is
+ * set, the non-empty buckets are also added as a "histogram" array of
+ * [lower bound, count] pairs, the lower bound of the first bucket being 0. */
+void histogram_output(const histogram_t *histogram, struct json_object *obj,
+		int with_buckets);
+
+#endif
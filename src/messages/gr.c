@@ -18,9 +18,40 @@ new_struct_simple(gr_replica_update,
 		// - dummy value
 		// - update_time_no_skew
 
-new_struct_simple(gr_slice_request, 0)
+new_struct_with_1_trailer(gr_replica_update_batch, 0,
+		num_updates, gr_replica_update_entry_t,
+		sizeof(gr_replica_update_entry_t)
+		+ GR_SIMULATED_VALUE_SIZE - sizeof(gr_value) - sizeof(gr_tsp))
 
-new_struct_simple(gr_slice_response, GR_SIMULATED_VALUE_SIZE - sizeof(gr_value))
+gr_slice_request_t *gr_slice_request_pooled(message_pool_t *pool,
+		unsigned int num_keys)
+{
+	size_t size = sizeof(gr_slice_request_t)
+		+ num_keys * sizeof(gr_key)
+		+ num_keys * sizeof(unsigned int);
+	gr_slice_request_t *request =
+		message_pool_get(pool, POOLED_gr_slice_request, size);
+	request->num_keys = num_keys;
+	request->message.size = size;
+	request->message.simulated_size = size;
+	return request;
+}
+
+gr_slice_response_t *gr_slice_response_pooled(message_pool_t *pool,
+		unsigned int num_values)
+{
+	size_t size = sizeof(gr_slice_response_t)
+		+ num_values * sizeof(unsigned int)
+		+ num_values * sizeof(gr_tsp)
+		+ num_values * sizeof(gr_value);
+	gr_slice_response_t *response =
+		message_pool_get(pool, POOLED_gr_slice_response, size);
+	response->num_values = num_values;
+	response->message.size = size;
+	response->message.simulated_size = size
+		+ num_values * (GR_SIMULATED_VALUE_SIZE - sizeof(gr_value));
+	return response;
+}
 
 new_struct_with_1_trailer(gr_get_snapshot_request, 0,
 		num_keys, gr_key, sizeof(gr_key))
@@ -38,4 +69,6 @@ new_struct_simple(gr_gst_from_root, 0)
 
 new_struct_simple(gr_lst_from_leaf, 0)
 
+new_struct_simple(gr_lst_broadcast, 0)
+
 new_struct_simple(gr_heartbeat, 0)
@@ -4,6 +4,7 @@
 #include "common.h"
 #include "gentle_rain.h"
 #include "messages/message.h"
+#include "messages/pool.h"
 
 typedef simtime_t gr_gst;
 
@@ -16,6 +17,7 @@ typedef struct gr_get_request {
 } gr_get_request_t;
 
 gr_get_request_t *gr_get_request_new(void);
+gr_get_request_t *gr_get_request_pooled(message_pool_t *pool);
 
 typedef struct gr_get_response {
 	MESSAGE_STRUCT_START;
@@ -26,6 +28,7 @@ typedef struct gr_get_response {
 } gr_get_response_t;
 
 gr_get_response_t *gr_get_response_new(void);
+gr_get_response_t *gr_get_response_pooled(message_pool_t *pool);
 
 typedef struct gr_put_request {
 	MESSAGE_STRUCT_START;
@@ -37,6 +40,7 @@ typedef struct gr_put_request {
 } gr_put_request_t;
 
 gr_put_request_t *gr_put_request_new(void);
+gr_put_request_t *gr_put_request_pooled(message_pool_t *pool);
 
 typedef struct gr_put_response {
 	MESSAGE_STRUCT_START;
@@ -45,6 +49,7 @@ typedef struct gr_put_response {
 } gr_put_response_t;
 
 gr_put_response_t *gr_put_response_new(void);
+gr_put_response_t *gr_put_response_pooled(message_pool_t *pool);
 
 typedef struct gr_replica_update {
 	MESSAGE_STRUCT_START;
@@ -58,6 +63,30 @@ typedef struct gr_replica_update {
 } gr_replica_update_t;
 
 gr_replica_update_t *gr_replica_update_new(void);
+gr_replica_update_t *gr_replica_update_pooled(message_pool_t *pool);
+
+typedef struct gr_replica_update_entry {
+	gr_key key;
+	gr_value value;
+	gr_tsp update_time;
+	gr_tsp update_time_no_skew;
+	gr_tsp previous_update_time;
+	replica_t previous_source_replica;
+} gr_replica_update_entry_t;
+
+typedef struct gr_replica_update_batch {
+	MESSAGE_STRUCT_START;
+	replica_t source_replica;
+	gr_tsp time; // No further update from the source will be older
+	unsigned int num_updates; // Updates are trailing behind this struct
+} gr_replica_update_batch_t;
+
+#define gr_replica_update_batch_updates(batch) \
+	((gr_replica_update_entry_t*) (batch + 1))
+
+gr_replica_update_batch_t *gr_replica_update_batch_new(unsigned int num_updates);
+gr_replica_update_batch_t *gr_replica_update_batch_pooled(message_pool_t *pool,
+		unsigned int num_updates);
 
 typedef struct gr_gst_from_root {
 	MESSAGE_STRUCT_START;
@@ -65,6 +94,7 @@ typedef struct gr_gst_from_root {
 } gr_gst_from_root_t;
 
 gr_gst_from_root_t *gr_gst_from_root_new(void);
+gr_gst_from_root_t *gr_gst_from_root_pooled(message_pool_t *pool);
 
 typedef struct gr_heartbeat {
 	MESSAGE_STRUCT_START;
@@ -73,6 +103,7 @@ typedef struct gr_heartbeat {
 } gr_heartbeat_t;
 
 gr_heartbeat_t *gr_heartbeat_new(void);
+gr_heartbeat_t *gr_heartbeat_pooled(message_pool_t *pool);
 
 typedef struct gr_lst_from_leaf {
 	MESSAGE_STRUCT_START;
@@ -81,6 +112,17 @@ typedef struct gr_lst_from_leaf {
 } gr_lst_from_leaf_t;
 
 gr_lst_from_leaf_t *gr_lst_from_leaf_new(void);
+gr_lst_from_leaf_t *gr_lst_from_leaf_pooled(message_pool_t *pool);
+
+typedef struct gr_lst_broadcast {
+	MESSAGE_STRUCT_START;
+	unsigned int partition_id;
+	gr_tsp lst;
+	gr_tsp gst;
+} gr_lst_broadcast_t;
+
+gr_lst_broadcast_t *gr_lst_broadcast_new(void);
+gr_lst_broadcast_t *gr_lst_broadcast_pooled(message_pool_t *pool);
 
 typedef struct gr_get_snapshot_request {
 	MESSAGE_STRUCT_START;
@@ -95,6 +137,8 @@ typedef struct gr_get_snapshot_request {
 	((gr_key*) (request + 1))
 
 gr_get_snapshot_request_t *gr_get_snapshot_request_new(unsigned int num_keys);
+gr_get_snapshot_request_t *gr_get_snapshot_request_pooled(message_pool_t *pool,
+		unsigned int num_keys);
 
 typedef struct gr_get_snapshot_response {
 	MESSAGE_STRUCT_START;
@@ -109,28 +153,42 @@ typedef struct gr_get_snapshot_response {
 	((gr_value*) (response + 1))
 
 gr_get_snapshot_response_t *gr_get_snapshot_response_new(unsigned int num_keys);
+gr_get_snapshot_response_t *gr_get_snapshot_response_pooled(message_pool_t *pool,
+		unsigned int num_keys);
 
 typedef struct gr_slice_request {
 	MESSAGE_STRUCT_START;
 	lpid_t from_lpid;
 	gr_tsp snapshot_time;
 	unsigned int snapshot_id;
-	gr_key key;
-	unsigned int key_id;
+	unsigned int num_keys; // Keys and key_ids are trailing behind this struct
 } gr_slice_request_t;
 
-gr_slice_request_t *gr_slice_request_new(void);
+#define gr_slice_request_keys(request) \
+	((gr_key*) (request + 1))
+#define gr_slice_request_key_ids(request) \
+	((unsigned int*) (gr_slice_request_keys(request) + request->num_keys))
+
+gr_slice_request_t *gr_slice_request_pooled(message_pool_t *pool,
+		unsigned int num_keys);
 
 typedef struct gr_slice_response {
 	MESSAGE_STRUCT_START;
 	unsigned int snapshot_id;
-	gr_value value;
-	gr_tsp update_time;
 	gr_tsp gst;
-	unsigned int key_id;
+	unsigned int num_values;
+	// Key_ids, update times and values are trailing behind this struct
 } gr_slice_response_t;
 
-gr_slice_response_t *gr_slice_response_new(void);
+#define gr_slice_response_key_ids(response) \
+	((unsigned int*) (response + 1))
+#define gr_slice_response_update_times(response) \
+	((gr_tsp*) (gr_slice_response_key_ids(response) + response->num_values))
+#define gr_slice_response_values(response) \
+	((gr_value*) (gr_slice_response_update_times(response) + response->num_values))
+
+gr_slice_response_t *gr_slice_response_pooled(message_pool_t *pool,
+		unsigned int num_values);
 
 typedef struct gr_get_rotx_request {
 	MESSAGE_STRUCT_START;
@@ -144,6 +202,8 @@ typedef struct gr_get_rotx_request {
 	((gr_key*) (request + 1))
 
 gr_get_rotx_request_t *gr_get_rotx_request_new(unsigned int num_keys);
+gr_get_rotx_request_t *gr_get_rotx_request_pooled(message_pool_t *pool,
+		unsigned int num_keys);
 
 typedef struct gr_get_rotx_response {
 	MESSAGE_STRUCT_START;
@@ -157,5 +217,7 @@ typedef struct gr_get_rotx_response {
 	((gr_value*) (response + 1))
 
 gr_get_rotx_response_t *gr_get_rotx_response_new(unsigned int num_values);
+gr_get_rotx_response_t *gr_get_rotx_response_pooled(message_pool_t *pool,
+		unsigned int num_values);
 
 #endif
@@ -24,14 +24,30 @@ new_struct_with_1_trailer(grv_replica_update,
 		// - update_time_no_skew
 		dependency_vector_size, gr_tsp, sizeof(gr_tsp))
 
-grv_slice_request_t *grv_slice_request_new(unsigned int num_keys,
-		unsigned int gst_vector_size)
+grv_replica_update_batch_t *grv_replica_update_batch_pooled(message_pool_t *pool,
+		unsigned int num_updates, unsigned int dependency_vector_size)
+{
+	size_t size = sizeof(grv_replica_update_batch_t)
+		+ num_updates * grv_replica_update_entry_size(dependency_vector_size);
+	grv_replica_update_batch_t *batch =
+		message_pool_get(pool, POOLED_grv_replica_update_batch, size);
+	batch->num_updates = num_updates;
+	batch->dependency_vector_size = dependency_vector_size;
+	batch->message.size = size;
+	batch->message.simulated_size = size + num_updates
+		* (GR_SIMULATED_VALUE_SIZE - sizeof(gr_value) - sizeof(gr_tsp));
+	return batch;
+}
+
+grv_slice_request_t *grv_slice_request_pooled(message_pool_t *pool,
+		unsigned int num_keys, unsigned int gst_vector_size)
 {
 	size_t size = sizeof(grv_slice_request_t)
 		+ num_keys * sizeof(gr_key)
 		+ num_keys * sizeof(unsigned int)
 		+ gst_vector_size * sizeof(gr_tsp);
-	grv_slice_request_t *request =  malloc(size);
+	grv_slice_request_t *request =
+		message_pool_get(pool, POOLED_grv_slice_request, size);
 	request->num_keys = num_keys;
 	request->gst_vector_size = gst_vector_size;
 	request->message.size = size;
@@ -39,14 +55,16 @@ grv_slice_request_t *grv_slice_request_new(unsigned int num_keys,
 	return request;
 }
 
-grv_slice_response_t *grv_slice_response_new(unsigned int num_values)
+grv_slice_response_t *grv_slice_response_pooled(message_pool_t *pool,
+		unsigned int num_values)
 {
 	size_t size =  sizeof(grv_slice_response_t)
 		+ num_values * sizeof(unsigned int)
 		+ num_values * sizeof(gr_value)
 		+ num_values * sizeof(gr_tsp)
 		+ num_values * sizeof(replica_t);
-	grv_slice_response_t *response = malloc(size);
+	grv_slice_response_t *response =
+		message_pool_get(pool, POOLED_grv_slice_response, size);
 	response->num_values = num_values;
 	response->message.size = size;
 	response->message.simulated_size = size
@@ -3,6 +3,7 @@
 
 #include "gentle_rain.h"
 #include "messages/message.h"
+#include "messages/pool.h"
 
 typedef simtime_t gr_gst;
 
@@ -18,6 +19,8 @@ typedef struct grv_get_request {
 	((gr_tsp*) (request + 1))
 
 grv_get_request_t *grv_get_request_new(unsigned int gst_vector_size);
+grv_get_request_t *grv_get_request_pooled(message_pool_t *pool,
+		unsigned int gst_vector_size);
 
 typedef struct grv_get_response {
 	MESSAGE_STRUCT_START;
@@ -33,6 +36,8 @@ typedef struct grv_get_response {
 	((gr_tsp*) (response + 1))
 
 grv_get_response_t *grv_get_response_new(unsigned int gst_vector_size);
+grv_get_response_t *grv_get_response_pooled(message_pool_t *pool,
+		unsigned int gst_vector_size);
 
 typedef struct grv_put_request {
 	MESSAGE_STRUCT_START;
@@ -47,6 +52,8 @@ typedef struct grv_put_request {
 	((gr_tsp *) (request + 1))
 
 grv_put_request_t *grv_put_request_new(unsigned int dependency_vector_size);
+grv_put_request_t *grv_put_request_pooled(message_pool_t *pool,
+		unsigned int dependency_vector_size);
 
 typedef struct grv_put_response {
 	MESSAGE_STRUCT_START;
@@ -56,6 +63,7 @@ typedef struct grv_put_response {
 } grv_put_response_t;
 
 grv_put_response_t *grv_put_response_new(void);
+grv_put_response_t *grv_put_response_pooled(message_pool_t *pool);
 
 typedef struct grv_replica_update {
 	MESSAGE_STRUCT_START;
@@ -73,6 +81,39 @@ typedef struct grv_replica_update {
 	((gr_tsp*) (update + 1))
 
 grv_replica_update_t *grv_replica_update_new(unsigned int dependency_vector_size);
+grv_replica_update_t *grv_replica_update_pooled(message_pool_t *pool,
+		unsigned int dependency_vector_size);
+
+typedef struct grv_replica_update_entry {
+	gr_key key;
+	gr_value value;
+	gr_tsp update_time;
+	gr_tsp update_time_no_skew;
+	gr_tsp previous_update_time;
+	replica_t previous_source_replica;
+	// The dependency vector is trailing behind the struct
+} grv_replica_update_entry_t;
+
+#define grv_replica_update_entry_dependency_vector(entry) \
+	((gr_tsp*) (entry + 1))
+
+typedef struct grv_replica_update_batch {
+	MESSAGE_STRUCT_START;
+	replica_t source_replica;
+	gr_tsp time; // No further update from the source will be older
+	unsigned int num_updates; // Updates are trailing behind the struct
+	unsigned int dependency_vector_size;
+} grv_replica_update_batch_t;
+
+#define grv_replica_update_entry_size(dependency_vector_size) \
+	(sizeof(grv_replica_update_entry_t) \
+	 + (dependency_vector_size) * sizeof(gr_tsp))
+#define grv_replica_update_batch_update(batch, i) \
+	((grv_replica_update_entry_t*) ((char*) (batch + 1) + (i) \
+		* grv_replica_update_entry_size(batch->dependency_vector_size)))
+
+grv_replica_update_batch_t *grv_replica_update_batch_pooled(message_pool_t *pool,
+		unsigned int num_updates, unsigned int dependency_vector_size);
 
 typedef struct heartbeat {
 	MESSAGE_STRUCT_START;
@@ -81,6 +122,7 @@ typedef struct heartbeat {
 } grv_heartbeat_t;
 
 grv_heartbeat_t *grv_heartbeat_new(void);
+grv_heartbeat_t *grv_heartbeat_pooled(message_pool_t *pool);
 
 typedef struct grv_gst_from_root {
 	MESSAGE_STRUCT_START;
@@ -92,6 +134,8 @@ typedef struct grv_gst_from_root {
 	((gr_tsp*) (root_gst + 1))
 
 grv_gst_from_root_t *grv_gst_from_root_new(unsigned int gst_vector_size);
+grv_gst_from_root_t *grv_gst_from_root_pooled(message_pool_t *pool,
+		unsigned int gst_vector_size);
 
 typedef struct grv_lst_from_leaf {
 	MESSAGE_STRUCT_START;
@@ -103,6 +147,8 @@ typedef struct grv_lst_from_leaf {
 	((gr_tsp*) (leaf_lst + 1))
 
 grv_lst_from_leaf_t *grv_lst_from_leaf_new(unsigned int lst_vector_size);
+grv_lst_from_leaf_t *grv_lst_from_leaf_pooled(message_pool_t *pool,
+		unsigned int lst_vector_size);
 
 typedef struct grv_slice_request {
 	MESSAGE_STRUCT_START;
@@ -120,8 +166,8 @@ typedef struct grv_slice_request {
 #define grv_slice_request_gst_vector(request) \
 	((gr_tsp*) (grv_slice_request_key_ids(request) + request->num_keys))
 
-grv_slice_request_t *grv_slice_request_new(unsigned int num_keys,
-		unsigned int gst_vector_size);
+grv_slice_request_t *grv_slice_request_pooled(message_pool_t *pool,
+		unsigned int num_keys, unsigned int gst_vector_size);
 
 typedef struct grv_slice_response {
 	MESSAGE_STRUCT_START;
@@ -140,7 +186,8 @@ typedef struct grv_slice_response {
 #define grv_slice_response_source_replicas(response) \
 	((unsigned int*) (grv_slice_response_update_times(response) + response->num_values))
 
-grv_slice_response_t *grv_slice_response_new(unsigned int num_values);
+grv_slice_response_t *grv_slice_response_pooled(message_pool_t *pool,
+		unsigned int num_values);
 
 typedef struct grv_rotx_request {
 	MESSAGE_STRUCT_START;
@@ -158,6 +205,8 @@ typedef struct grv_rotx_request {
 
 grv_rotx_request_t *grv_rotx_request_new(unsigned int num_keys,
 		unsigned int gst_vector_size);
+grv_rotx_request_t *grv_rotx_request_pooled(message_pool_t *pool,
+		unsigned int num_keys, unsigned int gst_vector_size);
 
 typedef struct grv_rotx_response {
 	MESSAGE_STRUCT_START;
@@ -173,5 +222,7 @@ typedef struct grv_rotx_response {
 
 grv_rotx_response_t *grv_rotx_response_new(unsigned int num_values,
 		unsigned int dependency_vector_size);
+grv_rotx_response_t *grv_rotx_response_pooled(message_pool_t *pool,
+		unsigned int num_values, unsigned int dependency_vector_size);
 
 #endif
@@ -1,47 +1,93 @@
 #ifndef messages_macros_h
 #define messages_macros_h
 
+#include "messages/pool.h"
+
+/* Each macro defines name##_new(), returning a message allocated with
+ * malloc(), and name##_pooled(), returning a message built in the buffer of
+ * its type in the given pool (see messages/pool.h). */
+
 #define new_struct_simple(name, additional_size) \
-	name##_t *name##_new(void) \
+	static name##_t *name##_init(void *buffer, size_t size) \
 	{ \
-		size_t size = sizeof(name##_t); \
-		name##_t *ptr = malloc(size); \
+		name##_t *ptr = buffer; \
 		ptr->message.size = size; \
 		ptr->message.simulated_size = size + (additional_size); \
 		return ptr; \
+	} \
+	name##_t *name##_new(void) \
+	{ \
+		size_t size = sizeof(name##_t); \
+		return name##_init(malloc(size), size); \
+	} \
+	name##_t *name##_pooled(message_pool_t *pool) \
+	{ \
+		size_t size = sizeof(name##_t); \
+		return name##_init(message_pool_get(pool, POOLED_##name, size), \
+				size); \
 	}
 
 #define new_struct_with_1_trailer(name, additional_size, \
 		count_member, trailing_type, simulated_element_size) \
-	name##_t *name##_new(unsigned int count_member) \
+	static size_t name##_size(unsigned int count_member) \
+	{ \
+		return sizeof(name##_t) + count_member * sizeof(trailing_type); \
+	} \
+	static name##_t *name##_init(void *buffer, unsigned int count_member) \
 	{ \
-		size_t size = sizeof(name##_t) + count_member * sizeof(trailing_type); \
-		name##_t *ptr = malloc(size); \
+		name##_t *ptr = buffer; \
 		ptr->count_member = count_member; \
-		ptr->message.size = size; \
+		ptr->message.size = name##_size(count_member); \
 		ptr->message.simulated_size = sizeof(name##_t) \
 			+ (additional_size) \
 			+ count_member * (simulated_element_size); \
 		return ptr; \
+	} \
+	name##_t *name##_new(unsigned int count_member) \
+	{ \
+		return name##_init(malloc(name##_size(count_member)), \
+				count_member); \
+	} \
+	name##_t *name##_pooled(message_pool_t *pool, unsigned int count_member) \
+	{ \
+		return name##_init(message_pool_get(pool, POOLED_##name, \
+					name##_size(count_member)), count_member); \
 	}
 
 #define new_struct_with_2_trailer(name, additional_size, \
 		count_member1, trailing_type1, simulated_size1, \
 		count_member2, trailing_type2, simulated_size2) \
-	name##_t *name##_new(unsigned int count_member1, unsigned int count_member2) \
+	static size_t name##_size(unsigned int count_member1, \
+			unsigned int count_member2) \
 	{ \
-		size_t size = sizeof(name##_t) \
+		return sizeof(name##_t) \
 			+ count_member1 * sizeof(trailing_type1) \
 			+ count_member2 * sizeof(trailing_type2); \
-		name##_t *ptr = malloc(size); \
+	} \
+	static name##_t *name##_init(void *buffer, unsigned int count_member1, \
+			unsigned int count_member2) \
+	{ \
+		name##_t *ptr = buffer; \
 		ptr->count_member1 = count_member1; \
 		ptr->count_member2 = count_member2; \
-		ptr->message.size = size; \
+		ptr->message.size = name##_size(count_member1, count_member2); \
 		ptr->message.simulated_size = sizeof(name##_t) \
 			+ (additional_size) \
 			+ count_member1 * (simulated_size1) \
 			+ count_member2 * (simulated_size2); \
 		return ptr; \
+	} \
+	name##_t *name##_new(unsigned int count_member1, unsigned int count_member2) \
+	{ \
+		return name##_init(malloc(name##_size(count_member1, count_member2)), \
+				count_member1, count_member2); \
+	} \
+	name##_t *name##_pooled(message_pool_t *pool, unsigned int count_member1, \
+			unsigned int count_member2) \
+	{ \
+		return name##_init(message_pool_get(pool, POOLED_##name, \
+					name##_size(count_member1, count_member2)), \
+				count_member1, count_member2); \
 	}
 
 #endif
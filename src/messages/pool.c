@@ -0,0 +1,18 @@
+#include "messages/pool.h"
+#include <stdlib.h>
+
+message_pool_t *message_pool_new(void)
+{
+	return calloc(1, sizeof(message_pool_t));
+}
+
+void *message_pool_get(message_pool_t *pool, pooled_message_t type,
+		size_t size)
+{
+	if (pool->sizes[type] < size) {
+		free(pool->buffers[type]);
+		pool->buffers[type] = malloc(size);
+		pool->sizes[type] = size;
+	}
+	return pool->buffers[type];
+}
@@ -0,0 +1,74 @@
+/* messages/pool.{c,h}
+ *
+ * Per-LP buffers for building outgoing messages. As a sent message is copied
+ * by ROOT-Sim, the buffer it was built in can be reused for the next message
+ * of the same type instead of being freed. A buffer grows to the largest
+ * message built in it, so that messages with trailing arrays are only
+ * reallocated until the largest size is reached.
+ *
+ * A message obtained with one of the *_pooled() constructors is only valid
+ * until the next message of the same type is built from the same pool and
+ * must not be freed.
+ */
+
+#ifndef messages_pool_h
+#define messages_pool_h
+
+#include <stddef.h>
+
+#define FOREACH_POOLED_MESSAGE(FUNC) \
+	FUNC(gr_get_request) \
+	FUNC(gr_get_response) \
+	FUNC(gr_put_request) \
+	FUNC(gr_put_response) \
+	FUNC(gr_replica_update) \
+	FUNC(gr_replica_update_batch) \
+	FUNC(gr_get_snapshot_request) \
+	FUNC(gr_get_snapshot_response) \
+	FUNC(gr_slice_request) \
+	FUNC(gr_slice_response) \
+	FUNC(gr_get_rotx_request) \
+	FUNC(gr_get_rotx_response) \
+	FUNC(gr_gst_from_root) \
+	FUNC(gr_lst_from_leaf) \
+	FUNC(gr_lst_broadcast) \
+	FUNC(gr_heartbeat) \
+	\
+	FUNC(grv_get_request) \
+	FUNC(grv_get_response) \
+	FUNC(grv_put_request) \
+	FUNC(grv_put_response) \
+	FUNC(grv_replica_update) \
+	FUNC(grv_replica_update_batch) \
+	FUNC(grv_slice_request) \
+	FUNC(grv_slice_response) \
+	FUNC(grv_rotx_request) \
+	FUNC(grv_rotx_response) \
+	FUNC(grv_heartbeat) \
+	FUNC(grv_lst_from_leaf) \
+	FUNC(grv_gst_from_root)
+
+#define POOLED_MESSAGE_ITEM(NAME) POOLED_##NAME,
+
+typedef enum {
+	FOREACH_POOLED_MESSAGE(POOLED_MESSAGE_ITEM)
+	NUM_POOLED_MESSAGES // Must be the last element
+} pooled_message_t;
+
+#undef POOLED_MESSAGE_ITEM
+
+typedef struct message_pool message_pool_t;
+
+struct message_pool {
+	void *buffers[NUM_POOLED_MESSAGES];
+	size_t sizes[NUM_POOLED_MESSAGES];
+};
+
+message_pool_t *message_pool_new(void);
+
+/* Return the buffer of the given message type, grown to at least size
+ * bytes. Its previous content is lost. */
+void *message_pool_get(message_pool_t *pool, pooled_message_t type,
+		size_t size);
+
+#endif
@@ -0,0 +1,77 @@
+#include "min_heap.h"
+#include <assert.h>
+#include <stdlib.h>
+
+#define INITIAL_HEAP_SIZE 8
+
+void min_heap_init(min_heap_t *heap)
+{
+	heap->size = 0;
+	heap->allocated_size = 0;
+	heap->entries = NULL;
+}
+
+static void swap(min_heap_t *heap, unsigned int a, unsigned int b)
+{
+	min_heap_entry_t tmp = heap->entries[a];
+	heap->entries[a] = heap->entries[b];
+	heap->entries[b] = tmp;
+}
+
+void min_heap_push(min_heap_t *heap, double key, unsigned int value)
+{
+	if (heap->size == heap->allocated_size) {
+		if (heap->allocated_size == 0) {
+			heap->allocated_size = INITIAL_HEAP_SIZE;
+		} else {
+			heap->allocated_size *= 2;
+		}
+		heap->entries = realloc(heap->entries,
+				heap->allocated_size * sizeof(min_heap_entry_t));
+	}
+	unsigned int i = heap->size;
+	++heap->size;
+	heap->entries[i].key = key;
+	heap->entries[i].value = value;
+	while (i > 0 && heap->entries[(i - 1) / 2].key > heap->entries[i].key) {
+		swap(heap, i, (i - 1) / 2);
+		i = (i - 1) / 2;
+	}
+}
+
+min_heap_entry_t *min_heap_peek(min_heap_t *heap)
+{
+	if (heap->size == 0) {
+		return NULL;
+	}
+	return &heap->entries[0];
+}
+
+void min_heap_pop(min_heap_t *heap)
+{
+	assert(heap->size > 0);
+	--heap->size;
+	heap->entries[0] = heap->entries[heap->size];
+	unsigned int i = 0;
+	for (;;) {
+		unsigned int smallest = i;
+		unsigned int left = 2 * i + 1;
+		unsigned int right = left + 1;
+		if (left < heap->size
+				&& heap->entries[left].key < heap->entries[smallest].key) {
+			smallest = left;
+		}
+		if (right < heap->size
+				&& heap->entries[right].key < heap->entries[smallest].key) {
+			smallest = right;
+		}
+		if (smallest == i) break;
+		swap(heap, i, smallest);
+		i = smallest;
+	}
+}
+
+unsigned int min_heap_size(min_heap_t *heap)
+{
+	return heap->size;
+}
@@ -0,0 +1,34 @@
+/* min_heap.{c,h}
+ *
+ * Binary min-heap of unsigned integers ordered by a floating point key.
+ */
+
+#ifndef min_heap_h
+#define min_heap_h
+
+typedef struct min_heap min_heap_t;
+typedef struct min_heap_entry min_heap_entry_t;
+
+struct min_heap_entry {
+	double key;
+	unsigned int value;
+};
+
+struct min_heap {
+	unsigned int size;
+	unsigned int allocated_size;
+	min_heap_entry_t *entries;
+};
+
+void min_heap_init(min_heap_t *heap);
+void min_heap_push(min_heap_t *heap, double key, unsigned int value);
+
+/* Return the entry with the smallest key or NULL if the heap is empty. */
+min_heap_entry_t *min_heap_peek(min_heap_t *heap);
+
+/* Remove the entry with the smallest key. */
+void min_heap_pop(min_heap_t *heap);
+
+unsigned int min_heap_size(min_heap_t *heap);
+
+#endif
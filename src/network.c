@@ -6,24 +6,268 @@
 #include <limits.h>
 
 #define DISCONNECTED -1
+#define NO_PEER UINT_MAX
+#define NO_OVERRIDE UINT64_MAX
 
+void *__real_malloc(size_t size);
+void __real_free(void *ptr);
 
 /* FIXME: There's currently no receive queue only a sending queue
  * This means congestion at the receiver is not simulated. */
 
+enum network_role {
+	NETWORK_UNKNOWN,
+	NETWORK_SERVER,
+	NETWORK_PARTITION_CLIENT, // Only talks to the server of its partition
+	NETWORK_REPLICA_CLIENT, // Talks to all the servers of its replica
+};
+
+struct network_location {
+	enum network_role role;
+	replica_t replica;
+	partition_t partition;
+};
+
+struct network_delay_override {
+	uint64_t link; // from_lp * num_lps + to_lp
+	simtime_t delay;
+};
+
+/* The propagation delay between two LPs is derived from their location,
+ * explicit delays set with network_set_delay() are kept in a small open
+ * addressing hash table. */
 struct network_config {
 	unsigned int num_lps;
+	unsigned int num_replicas;
 	double *transmission_rates;
-	simtime_t **network_delay;
+	struct network_location *locations;
+	simtime_t intra_datacenter_delay;
+	simtime_t self_delay;
+	simtime_t *inter_datacenter_delay; // num_replicas x num_replicas
+	unsigned int num_overrides;
+	unsigned int allocated_overrides; // Always a power of two
+	struct network_delay_override *overrides;
+};
+
+/* Each LP only talks to a handful of peers, so the reception time of the
+ * last message sent to each of them is kept in a small open addressing hash
+ * table rather than in an array indexed by lpid. */
+struct network_peer {
+	lpid_t lpid;
+	simtime_t last_reception_time;
 };
 
 struct network_state {
 	network_config_t *conf;
 	simtime_t busy_until;
 	simtime_t busy_time;
-	simtime_t last_reception_time_by_lp[MAX_LP];
+	unsigned int num_peers;
+	unsigned int allocated_peers; // Always a power of two
+	struct network_peer *peers;
 };
 
+static unsigned int peer_slot(network_state_t *state, lpid_t lpid)
+{
+	unsigned int mask = state->allocated_peers - 1;
+	unsigned int slot = (lpid * 2654435761u) & mask;
+	while (state->peers[slot].lpid != lpid
+			&& state->peers[slot].lpid != NO_PEER) {
+		slot = (slot + 1) & mask;
+	}
+	return slot;
+}
+
+static void allocate_peers(network_state_t *state, unsigned int size)
+{
+	state->allocated_peers = size;
+	state->peers = malloc(size * sizeof(struct network_peer));
+	for (unsigned int i = 0; i < size; ++i) {
+		state->peers[i].lpid = NO_PEER;
+		state->peers[i].last_reception_time = 0;
+	}
+}
+
+static struct network_peer *get_peer(network_state_t *state, lpid_t lpid)
+{
+	unsigned int slot = peer_slot(state, lpid);
+	if (state->peers[slot].lpid == lpid) {
+		return &state->peers[slot];
+	}
+	if (2 * (state->num_peers + 1) > state->allocated_peers) {
+		struct network_peer *old_peers = state->peers;
+		unsigned int old_size = state->allocated_peers;
+		allocate_peers(state, 2 * old_size);
+		for (unsigned int i = 0; i < old_size; ++i) {
+			if (old_peers[i].lpid != NO_PEER) {
+				state->peers[peer_slot(state, old_peers[i].lpid)] = old_peers[i];
+			}
+		}
+		free(old_peers);
+		slot = peer_slot(state, lpid);
+	}
+	++state->num_peers;
+	state->peers[slot].lpid = lpid;
+	return &state->peers[slot];
+}
+
+network_config_t *network_setup(unsigned int num_lps,
+		unsigned int num_replicas)
+{
+	network_config_t *conf = __real_malloc(sizeof(network_config_t));
+	conf->num_lps = num_lps;
+	conf->num_replicas = num_replicas;
+	conf->transmission_rates = __real_malloc(num_lps * sizeof(double));
+	conf->locations = __real_malloc(num_lps * sizeof(struct network_location));
+	for (unsigned int i = 0; i < num_lps; ++i) {
+		conf->transmission_rates[i] = 0;
+		conf->locations[i].role = NETWORK_UNKNOWN;
+	}
+
+	struct json_object *network_obj = param_get_object_root("network");
+	conf->intra_datacenter_delay = param_get_double(network_obj,
+			"intra_datacenter_delay");
+	conf->self_delay = param_get_double(network_obj, "self_delay");
+	struct json_object *inter_replica_delay_matrix =
+		param_get_double_matrix(network_obj, "inter_datacenter_delay",
+				num_replicas, num_replicas);
+	conf->inter_datacenter_delay = __real_malloc(
+			num_replicas * num_replicas * sizeof(simtime_t));
+	for (replica_t from = 0; from < num_replicas; ++from) {
+		for (replica_t to = 0; to < num_replicas; ++to) {
+			conf->inter_datacenter_delay[from * num_replicas + to] =
+				param_get_double_matrix_element(
+						inter_replica_delay_matrix, from, to);
+		}
+	}
+
+	conf->num_overrides = 0;
+	conf->allocated_overrides = 0;
+	conf->overrides = NULL;
+	return conf;
+}
+
+network_state_t *network_init(network_config_t *conf,
+		unsigned int expected_peers)
+{
+	network_state_t *state = malloc(sizeof(network_state_t));
+	state->conf = conf;
+	state->busy_until = 0;
+	state->busy_time = 0;
+	state->num_peers = 0;
+	unsigned int size = 4;
+	while (size < 2 * expected_peers) size *= 2;
+	allocate_peers(state, size);
+	return state;
+}
+
+static void set_location(network_config_t *conf, lpid_t lpid,
+		enum network_role role, replica_t replica, partition_t partition)
+{
+	assert(lpid < conf->num_lps);
+	assert(replica < conf->num_replicas);
+	conf->locations[lpid].role = role;
+	conf->locations[lpid].replica = replica;
+	conf->locations[lpid].partition = partition;
+}
+
+void network_set_server_location(network_config_t *conf, lpid_t lpid,
+		replica_t replica, partition_t partition)
+{
+	set_location(conf, lpid, NETWORK_SERVER, replica, partition);
+}
+
+void network_set_client_location(network_config_t *conf, lpid_t lpid,
+		replica_t replica, partition_t partition, int tied_to_partition)
+{
+	set_location(conf, lpid, tied_to_partition ? NETWORK_PARTITION_CLIENT
+			: NETWORK_REPLICA_CLIENT, replica, partition);
+}
+
+static unsigned int override_slot(network_config_t *conf, uint64_t link)
+{
+	unsigned int mask = conf->allocated_overrides - 1;
+	unsigned int slot = (unsigned int) ((link * 11400714819323198485u) >> 32) & mask;
+	while (conf->overrides[slot].link != link
+			&& conf->overrides[slot].link != NO_OVERRIDE) {
+		slot = (slot + 1) & mask;
+	}
+	return slot;
+}
+
+static void allocate_overrides(network_config_t *conf, unsigned int size)
+{
+	conf->allocated_overrides = size;
+	conf->overrides = __real_malloc(size * sizeof(struct network_delay_override));
+	for (unsigned int i = 0; i < size; ++i) {
+		conf->overrides[i].link = NO_OVERRIDE;
+	}
+}
+
+void network_set_delay(network_config_t *conf, lpid_t from_lp, lpid_t to_lp,
+		simtime_t delay)
+{
+	assert(from_lp < conf->num_lps);
+	assert(to_lp < conf->num_lps);
+	uint64_t link = (uint64_t) from_lp * conf->num_lps + to_lp;
+	if (2 * (conf->num_overrides + 1) > conf->allocated_overrides) {
+		struct network_delay_override *old_overrides = conf->overrides;
+		unsigned int old_size = conf->allocated_overrides;
+		allocate_overrides(conf, old_size == 0 ? 16 : 2 * old_size);
+		for (unsigned int i = 0; i < old_size; ++i) {
+			if (old_overrides[i].link != NO_OVERRIDE) {
+				conf->overrides[override_slot(conf, old_overrides[i].link)] =
+					old_overrides[i];
+			}
+		}
+		__real_free(old_overrides);
+	}
+	unsigned int slot = override_slot(conf, link);
+	if (conf->overrides[slot].link == NO_OVERRIDE) {
+		++conf->num_overrides;
+		conf->overrides[slot].link = link;
+	}
+	conf->overrides[slot].delay = delay;
+}
+
+static simtime_t network_delay(network_config_t *conf, lpid_t from_lp,
+		lpid_t to_lp)
+{
+	if (conf->num_overrides > 0) {
+		uint64_t link = (uint64_t) from_lp * conf->num_lps + to_lp;
+		unsigned int slot = override_slot(conf, link);
+		if (conf->overrides[slot].link == link) {
+			return conf->overrides[slot].delay;
+		}
+	}
+
+	struct network_location *from = &conf->locations[from_lp];
+	struct network_location *to = &conf->locations[to_lp];
+	if (from->role == NETWORK_UNKNOWN || to->role == NETWORK_UNKNOWN) {
+		return DISCONNECTED;
+	}
+	if (from->role == NETWORK_SERVER && to->role == NETWORK_SERVER) {
+		if (from_lp == to_lp) {
+			return conf->self_delay;
+		} else if (from->replica == to->replica) {
+			return conf->intra_datacenter_delay;
+		} else if (from->partition == to->partition) {
+			return conf->inter_datacenter_delay[
+				from->replica * conf->num_replicas + to->replica];
+		}
+		return DISCONNECTED;
+	}
+
+	// Clients are only connected to servers of their replica
+	struct network_location *client = from->role == NETWORK_SERVER ? to : from;
+	struct network_location *server = from->role == NETWORK_SERVER ? from : to;
+	if (server->role != NETWORK_SERVER || client->replica != server->replica
+			|| (client->role == NETWORK_PARTITION_CLIENT
+				&& client->partition != server->partition)) {
+		return DISCONNECTED;
+	}
+	return conf->intra_datacenter_delay;
+}
+
 void network_send(network_state_t *state, lpid_t from_lpid, lpid_t to_lpid,
 		simtime_t now, unsigned int event_type, void *data, size_t data_size,
 		size_t simulated_size)
@@ -32,7 +276,7 @@ void network_send(network_state_t *state, lpid_t from_lpid, lpid_t to_lpid,
 	assert(from_lpid < conf->num_lps);
 	assert(to_lpid < conf->num_lps);
 
-	simtime_t propagation_time = conf->network_delay[from_lpid][to_lpid];
+	simtime_t propagation_time = network_delay(conf, from_lpid, to_lpid);
 	assert(propagation_time != DISCONNECTED);
 	assert(propagation_time >= 0);
 	simtime_t transmission_rate = conf->transmission_rates[from_lpid];
@@ -48,8 +292,9 @@ void network_send(network_state_t *state, lpid_t from_lpid, lpid_t to_lpid,
 
 	// Ensure the message arrives after the previous one sent to the same
 	// destination.
-	assert(when >= state->last_reception_time_by_lp[to_lpid]);
-	state->last_reception_time_by_lp[to_lpid] = when;
+	struct network_peer *peer = get_peer(state, to_lpid);
+	assert(when >= peer->last_reception_time);
+	peer->last_reception_time = when;
 
 	assert(data_size <= UINT_MAX);
 	ScheduleNewEvent(to_lpid, when, event_type, data, (unsigned int) data_size);
@@ -60,40 +305,6 @@ void network_send(network_state_t *state, lpid_t from_lpid, lpid_t to_lpid,
 	}
 }
 
-network_config_t *network_setup(unsigned int num_lps)
-{
-	void *__real_malloc(size_t size);
-	network_config_t *conf = __real_malloc(sizeof(network_config_t));
-	conf->num_lps = num_lps;
-	conf->network_delay = __real_malloc(num_lps * sizeof(simtime_t*));
-	conf->transmission_rates = __real_malloc(num_lps * sizeof(double));
-	for (unsigned int i = 0; i < num_lps; ++i) {
-		conf->transmission_rates[i] = 0;
-		conf->network_delay[i] = __real_malloc(num_lps * sizeof(simtime_t));
-		for (unsigned int j = 0; j < num_lps; ++j) {
-			conf->network_delay[i][j] = DISCONNECTED;
-		}
-	}
-	return conf;
-}
-
-network_state_t *network_init(network_config_t *conf)
-{
-	network_state_t *state = malloc(sizeof(network_state_t));
-	state->conf = conf;
-	state->busy_until = 0;
-	state->busy_time = 0;
-	memset(state->last_reception_time_by_lp, 0,
-			MAX_LP * sizeof(*state->last_reception_time_by_lp));
-	return state;
-}
-
-void network_set_delay(network_config_t *conf, lpid_t from_lp, lpid_t to_lp,
-		simtime_t delay)
-{
-	conf->network_delay[from_lp][to_lp] = delay;
-}
-
 void network_set_transmission_rate(network_config_t *conf, lpid_t lpid,
 		double rate)
 {
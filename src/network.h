@@ -13,8 +13,25 @@
 typedef struct network_config network_config_t;
 typedef struct network_state network_state_t;
 
-network_config_t *network_setup(unsigned int num_lps);
-network_state_t *network_init(network_config_t *conf);
+/* Read the "network" parameters. The delay of a message is derived from the
+ * location of the sender and receiver, which must be set with the
+ * network_set_*_location functions below. */
+network_config_t *network_setup(unsigned int num_lps,
+		unsigned int num_replicas);
+/* Initialize the network state of an LP. expected_peers is the number of LPs
+ * it is expected to send messages to, more peers are handled but require
+ * the state to grow. */
+network_state_t *network_init(network_config_t *conf,
+		unsigned int expected_peers);
+void network_set_server_location(network_config_t *conf, lpid_t lpid,
+		replica_t replica, partition_t partition);
+
+/* A client tied to its partition only talks to the server of that partition,
+ * otherwise it talks to all the servers of its replica. */
+void network_set_client_location(network_config_t *conf, lpid_t lpid,
+		replica_t replica, partition_t partition, int tied_to_partition);
+
+/* Override the delay derived from the location of the LPs. */
 void network_set_delay(network_config_t *state, lpid_t from_lp, lpid_t to_lp,
 		simtime_t delay);
 
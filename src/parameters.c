@@ -61,9 +61,6 @@ timing_distributions[TIMING_DISTRIBUTIONS_SIZE] = {
 
 DEFINE_TIMING_FUNC(build_struct_per_byte_time);
 
-static double param_get_double_default(struct json_object *obj, const char *name,
-		double default_value);
-
 static void set_application_parameters(struct app_parameters *app)
 {
 	/* "application" object and app_params global variable */
@@ -80,6 +77,8 @@ static void set_application_parameters(struct app_parameters *app)
 	}
 	app->ignore_initial_seconds = param_get_double_default(
 			application_obj, "ignore_initial_seconds", 0);
+	app->inline_uncontended_locks = param_get_uint_default(
+			application_obj, "inline_uncontended_locks", 0);
 
 	const char *protocol = param_get_string(application_obj, "protocol");
 	for (int i = 0; ; ++i) {
@@ -225,7 +224,7 @@ double param_get_double(struct json_object *obj, const char *name)
 	return json_object_get_double(value);
 }
 
-static double param_get_double_default(struct json_object *obj, const char *name,
+double param_get_double_default(struct json_object *obj, const char *name,
 		double default_value)
 {
 	struct json_object *value;
@@ -257,6 +256,17 @@ unsigned int param_get_uint(struct json_object *obj, const char *name)
 	return (unsigned int) value;
 }
 
+unsigned int param_get_uint_default(struct json_object *obj, const char *name,
+		unsigned int default_value)
+{
+	struct json_object *value;
+	assert(json_object_is_type(obj, json_type_object));
+	if (!json_object_object_get_ex(obj, name, &value)) {
+		return default_value;
+	}
+	return param_get_uint(obj, name);
+}
+
 const char *param_get_string(struct json_object *obj, const char *name)
 {
 	struct json_object *value = param_get(obj, name);
@@ -266,6 +276,17 @@ const char *param_get_string(struct json_object *obj, const char *name)
 	return json_object_get_string(value);
 }
 
+const char *param_get_string_default(struct json_object *obj,
+		const char *name, const char *default_value)
+{
+	struct json_object *value;
+	assert(json_object_is_type(obj, json_type_object));
+	if (!json_object_object_get_ex(obj, name, &value)) {
+		return default_value;
+	}
+	return param_get_string(obj, name);
+}
+
 struct json_object *param_get_double_matrix(struct json_object *obj,
 		const char *name, unsigned int width, unsigned int height)
 {
@@ -111,11 +111,32 @@ simtime_t build_struct_per_byte_time(void);
 #define DEFINE_PROTOCOL_PARAMETER_FUNC(name, type, protocol) \
 	DEFINE_PARAMETER_FUNC_2(name, type, "protocol", protocol)
 
+/** .. c:macro:: DEFINE_PROTOCOL_PARAMETER_DEFAULT_FUNC
+ *
+ *  Same as :c:macro:`DEFINE_PROTOCOL_PARAMETER_FUNC` but for an optional
+ *  parameter, the function returns `default_value` when it is missing.
+ */
+#define DEFINE_PROTOCOL_PARAMETER_DEFAULT_FUNC(name, type, protocol, default_value) \
+	type name(void) \
+	{ \
+		static type value; \
+		static int valid; \
+		if (!valid) { \
+			struct json_object *obj = param_get_object_root("protocol"); \
+			obj = param_get_object(obj, protocol); \
+			value = param_get_##type##_default(obj, STRINGIFY(name), \
+					default_value); \
+			valid = 1; \
+		} \
+		return value; \
+	}
+
 struct app_parameters {
 	struct json_object *json_config;
 	simtime_t stop_after_simulated_seconds;
 	time_t stop_after_real_time;
 	simtime_t ignore_initial_seconds;
+	unsigned int inline_uncontended_locks;
 };
 
 void parameters_read_from_file(const char *path,
@@ -135,9 +156,15 @@ struct json_object *param_get_object_root(const char *name);
 struct json_object *param_get_workload_object(const char *name);
 struct json_object *param_get_timing_protocol_object(const char *protocol);
 double param_get_double(struct json_object *obj, const char *name);
+double param_get_double_default(struct json_object *obj, const char *name,
+		double default_value);
 int param_get_int(struct json_object *obj, const char *name);
 unsigned int param_get_uint(struct json_object *obj, const char *name);
+unsigned int param_get_uint_default(struct json_object *obj, const char *name,
+		unsigned int default_value);
 const char *param_get_string(struct json_object *obj, const char *name);
+const char *param_get_string_default(struct json_object *obj,
+		const char *name, const char *default_value);
 struct json_object *param_get_double_matrix(struct json_object *obj,
 		const char *name, unsigned int width, unsigned int height);
 double param_get_double_matrix_element(struct json_object *obj,
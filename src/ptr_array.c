@@ -1,17 +1,86 @@
 #include "ptr_array.h"
 #include <assert.h>
+#include <limits.h>
 #include <stdlib.h>
+#include <string.h>
 
 #define INITIAL_ARRAY_SIZE 4
+#define BITS_PER_WORD ((unsigned int) (sizeof(unsigned long) * CHAR_BIT))
+#define NOT_FREE UINT_MAX
 
 void ptr_array_init(ptr_array_t *array)
 {
 	array->size = 0;
+	array->count = 0;
 	array->allocated_size = 0;
 	array->data = NULL;
+	array->occupied = NULL;
+	array->free_ids_size = 0;
+	array->free_ids_allocated_size = 0;
+	array->free_ids = NULL;
+	array->free_id_positions = NULL;
 }
 ptr_array_t *ptr_array_new(void);
 
+static unsigned int bitmap_words(unsigned int size)
+{
+	return (size + BITS_PER_WORD - 1) / BITS_PER_WORD;
+}
+
+static void mark_occupied(ptr_array_t *array, unsigned int id)
+{
+	array->occupied[id / BITS_PER_WORD] |= 1UL << (id % BITS_PER_WORD);
+}
+
+static void mark_free(ptr_array_t *array, unsigned int id)
+{
+	array->occupied[id / BITS_PER_WORD] &= ~(1UL << (id % BITS_PER_WORD));
+}
+
+static void push_free_id(ptr_array_t *array, unsigned int id)
+{
+	if (array->free_ids_size == array->free_ids_allocated_size) {
+		if (array->free_ids_allocated_size == 0) {
+			array->free_ids_allocated_size = INITIAL_ARRAY_SIZE;
+		} else {
+			array->free_ids_allocated_size *= 2;
+		}
+		array->free_ids = realloc(array->free_ids,
+				array->free_ids_allocated_size * sizeof(unsigned int));
+	}
+	array->free_id_positions[id] = array->free_ids_size;
+	array->free_ids[array->free_ids_size++] = id;
+}
+
+/* Remove the given id from the stack of free ids by moving the top of the
+ * stack in its place. */
+static void remove_free_id(ptr_array_t *array, unsigned int id)
+{
+	unsigned int position = array->free_id_positions[id];
+	assert(position != NOT_FREE);
+	unsigned int last = array->free_ids[--array->free_ids_size];
+	array->free_ids[position] = last;
+	array->free_id_positions[last] = position;
+	array->free_id_positions[id] = NOT_FREE;
+}
+
+static void grow(ptr_array_t *array)
+{
+	unsigned int old_words = bitmap_words(array->allocated_size);
+	if (array->allocated_size == 0) {
+		array->allocated_size = INITIAL_ARRAY_SIZE;
+	} else {
+		array->allocated_size *= 2;
+	}
+	array->data = realloc(array->data, array->allocated_size * sizeof(void*));
+	array->free_id_positions = realloc(array->free_id_positions,
+			array->allocated_size * sizeof(unsigned int));
+	unsigned int words = bitmap_words(array->allocated_size);
+	array->occupied = realloc(array->occupied, words * sizeof(unsigned long));
+	memset(array->occupied + old_words, 0,
+			(words - old_words) * sizeof(unsigned long));
+}
+
 void *ptr_array_get(ptr_array_t *array, unsigned int id)
 {
 	assert(id < array->size);
@@ -21,38 +90,59 @@ void *ptr_array_get(ptr_array_t *array, unsigned int id)
 void ptr_array_set(ptr_array_t *array, unsigned int id, void *ptr)
 {
 	assert(id < array->size);
+	if (array->data[id] == NULL && ptr != NULL) {
+		++array->count;
+		mark_occupied(array, id);
+		remove_free_id(array, id);
+	} else if (array->data[id] != NULL && ptr == NULL) {
+		--array->count;
+		mark_free(array, id);
+		push_free_id(array, id);
+	}
 	array->data[id] = ptr;
 }
 
 unsigned int ptr_array_put(ptr_array_t *array, void *ptr)
 {
 	assert(ptr != NULL);
-	for (unsigned int i = 0; i < array->size; ++i) {
-		if (array->data[i] == NULL) {
-			array->data[i] = ptr;
-			return i;
-		}
+	++array->count;
+	if (array->free_ids_size > 0) {
+		unsigned int id = array->free_ids[--array->free_ids_size];
+		array->free_id_positions[id] = NOT_FREE;
+		array->data[id] = ptr;
+		mark_occupied(array, id);
+		return id;
 	}
 	if (array->size == array->allocated_size) {
-		if (array->allocated_size == 0) {
-			array->allocated_size = INITIAL_ARRAY_SIZE;
-		} else {
-			array->allocated_size *= 2;
-		}
-		array->data = realloc(array->data, array->allocated_size * sizeof(void*));
+		grow(array);
 	}
 	unsigned int id = array->size;
 	++array->size;
+	array->free_id_positions[id] = NOT_FREE;
 	array->data[id] = ptr;
+	mark_occupied(array, id);
 	return id;
 }
 
+unsigned int ptr_array_count(ptr_array_t *array)
+{
+	return array->count;
+}
+
 void ptr_array_foreach(ptr_array_t *array,
 		void (*f)(unsigned int id, void *value, void *data), void *data)
 {
-	for (unsigned int i = 0; i < array->size; ++i) {
-		if (array->data[i] != NULL) {
-			f(i, array->data[i], data);
+	unsigned int next = 0;
+	while (next < array->size) {
+		unsigned int word = next / BITS_PER_WORD;
+		// Re-read the bitmap after each call since f may modify the array.
+		unsigned long bits = array->occupied[word] >> (next % BITS_PER_WORD);
+		if (bits == 0) {
+			next = (word + 1) * BITS_PER_WORD;
+			continue;
 		}
+		unsigned int id = next + (unsigned int) __builtin_ctzl(bits);
+		next = id + 1;
+		f(id, array->data[id], data);
 	}
 }
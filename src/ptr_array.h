@@ -5,8 +5,16 @@ typedef struct ptr_array ptr_array_t;
 
 struct ptr_array {
 	unsigned int size;
+	unsigned int count; // Number of non-NULL pointers
 	unsigned int allocated_size;
 	void **data;
+	unsigned long *occupied; // Bitmap of the non-NULL pointers
+	// Stack of the ids whose pointer was set to NULL, and position of each id
+	// in it (NOT_FREE if the id is not in the stack).
+	unsigned int free_ids_size;
+	unsigned int free_ids_allocated_size;
+	unsigned int *free_ids;
+	unsigned int *free_id_positions;
 };
 
 void ptr_array_init(ptr_array_t *array);
@@ -18,10 +26,15 @@ void *ptr_array_get(ptr_array_t *array, unsigned int id);
 /* Set the pointer associated with the given id. */
 void ptr_array_set(ptr_array_t *array, unsigned int id, void *ptr);
 
-/* Set the first NULL pointer of the array to the given one and return its id. */
+/* Store the given pointer in a NULL slot of the array, preferably the most
+ * recently freed one, and return its id. */
 unsigned int ptr_array_put(ptr_array_t *array, void *ptr);
 
-/* Call f for each non-NULL element of the array. */
+/* Return the number of non-NULL pointers in the array. */
+unsigned int ptr_array_count(ptr_array_t *array);
+
+/* Call f for each non-NULL element of the array. Elements added by f with a
+ * greater id than the current one are also visited. */
 void ptr_array_foreach(ptr_array_t *array,
 		void (*f)(unsigned int id, void *value, void *data), void *data);
 
@@ -0,0 +1,87 @@
+#include "ring_buffer.h"
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define INITIAL_RING_SIZE 8
+
+void ring_buffer_init(ring_buffer_t *ring, size_t element_size)
+{
+	ring->element_size = element_size;
+	ring->head = 0;
+	ring->count = 0;
+	ring->allocated_size = 0;
+	ring->data = NULL;
+}
+
+static void *element_at(ring_buffer_t *ring, unsigned int slot)
+{
+	return ring->data + slot * ring->element_size;
+}
+
+static void grow(ring_buffer_t *ring)
+{
+	unsigned int old_size = ring->allocated_size;
+	ring->allocated_size = old_size == 0 ? INITIAL_RING_SIZE : 2 * old_size;
+	ring->data = realloc(ring->data, ring->allocated_size * ring->element_size);
+	// Move the wrapped-around part after the old end so that the elements
+	// are contiguous again starting from the head.
+	if (ring->head + ring->count > old_size) {
+		unsigned int wrapped = ring->head + ring->count - old_size;
+		memcpy(element_at(ring, old_size), element_at(ring, 0),
+				wrapped * ring->element_size);
+	}
+}
+
+void *ring_buffer_push(ring_buffer_t *ring, const void *element)
+{
+	if (ring->count == ring->allocated_size) {
+		grow(ring);
+	}
+	unsigned int slot = (ring->head + ring->count) % ring->allocated_size;
+	++ring->count;
+	void *copy = element_at(ring, slot);
+	memcpy(copy, element, ring->element_size);
+	return copy;
+}
+
+void *ring_buffer_get(ring_buffer_t *ring, unsigned int index)
+{
+	assert(index < ring->count);
+	return element_at(ring, (ring->head + index) % ring->allocated_size);
+}
+
+void *ring_buffer_peek(ring_buffer_t *ring)
+{
+	if (ring->count == 0) {
+		return NULL;
+	}
+	return element_at(ring, ring->head);
+}
+
+void ring_buffer_shift(ring_buffer_t *ring)
+{
+	assert(ring->count > 0);
+	ring->head = (ring->head + 1) % ring->allocated_size;
+	--ring->count;
+}
+
+void ring_buffer_swap(ring_buffer_t *ring, unsigned int a, unsigned int b)
+{
+	char tmp[ring->element_size];
+	void *element_a = ring_buffer_get(ring, a);
+	void *element_b = ring_buffer_get(ring, b);
+	memcpy(tmp, element_a, ring->element_size);
+	memcpy(element_a, element_b, ring->element_size);
+	memcpy(element_b, tmp, ring->element_size);
+}
+
+unsigned int ring_buffer_size(ring_buffer_t *ring)
+{
+	return ring->count;
+}
+
+int ring_buffer_is_empty(ring_buffer_t *ring)
+{
+	return ring->count == 0;
+}
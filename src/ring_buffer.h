@@ -0,0 +1,42 @@
+/* ring_buffer.{c,h}
+ *
+ * Growable FIFO storing fixed-size elements by value in a circular array.
+ */
+
+#ifndef ring_buffer_h
+#define ring_buffer_h
+
+#include <stddef.h>
+
+typedef struct ring_buffer ring_buffer_t;
+
+struct ring_buffer {
+	size_t element_size;
+	unsigned int head;
+	unsigned int count;
+	unsigned int allocated_size;
+	char *data;
+};
+
+void ring_buffer_init(ring_buffer_t *ring, size_t element_size);
+
+/* Copy the given element at the tail of the ring and return a pointer to
+ * the copy. */
+void *ring_buffer_push(ring_buffer_t *ring, const void *element);
+
+/* Return a pointer to the element at the given position, 0 being the head. */
+void *ring_buffer_get(ring_buffer_t *ring, unsigned int index);
+
+/* Return the head of the ring or NULL if it is empty. */
+void *ring_buffer_peek(ring_buffer_t *ring);
+
+/* Drop the head of the ring. */
+void ring_buffer_shift(ring_buffer_t *ring);
+
+/* Exchange the content of the elements at the two given positions. */
+void ring_buffer_swap(ring_buffer_t *ring, unsigned int a, unsigned int b);
+
+unsigned int ring_buffer_size(ring_buffer_t *ring);
+int ring_buffer_is_empty(ring_buffer_t *ring);
+
+#endif
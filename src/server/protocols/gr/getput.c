@@ -13,8 +13,8 @@
 struct gr_get_state {
 	gr_key key;
 	gr_gst gst;
+	lpid_t client_lpid;
 	lpid_t destination;
-	gr_get_response_t *response;
 };
 
 struct gr_get_state_message {
@@ -24,7 +24,8 @@ struct gr_get_state_message {
 struct gr_put_state {
 	gr_key key;
 	gr_value value;
-	gr_put_response_t *response;
+	gr_tsp update_time;
+	lpid_t client_lpid;
 	lpid_t destination;
 	simtime_t previous_update_time;
 	replica_t previous_source_replica;
@@ -42,7 +43,6 @@ static DEFINE_PROTOCOL_TIMING_FUNC(process_put_request_pre_time, "gr");
 static unsigned int gr_get_state_new(gr_server_state_t *state)
 {
 	gr_get_state_t *get_state = malloc(sizeof(gr_get_state_t));
-	get_state->response = gr_get_response_new();
 	return ptr_array_put(&state->get_states, get_state);
 }
 
@@ -50,7 +50,6 @@ static void gr_get_state_free(gr_server_state_t *state, unsigned int id)
 {
 	gr_get_state_t *get_state = ptr_array_get(&state->get_states, id);
 	ptr_array_set(&state->get_states, id, NULL);
-	free(get_state->response);
 	free(get_state);
 }
 
@@ -68,7 +67,6 @@ static size_t gr_get_state_message_size(gr_get_state_message_t *msg)
 static unsigned int gr_put_state_new(gr_server_state_t *state)
 {
 	gr_put_state_t *put_state = malloc(sizeof(gr_put_state_t));
-	put_state->response = gr_put_response_new();
 	return ptr_array_put(&state->put_states, put_state);
 }
 
@@ -76,7 +74,6 @@ static void gr_put_state_free(gr_server_state_t *state, unsigned int id)
 {
 	gr_put_state_t *put_state = ptr_array_get(&state->put_states, id);
 	ptr_array_set(&state->put_states, id, NULL);
-	free(put_state->response);
 	free(put_state);
 }
 
@@ -116,8 +113,7 @@ void gr_process_get_request(gr_server_state_t *state, gr_get_request_t *request)
 	get_state->gst = request->gst;
 	get_state->destination = request->proxy_lpid == NO_PROXY_LPID
 			? request->client_lpid : request->proxy_lpid;
-	gr_get_response_t *response = get_state->response;
-	response->client_lpid = request->client_lpid;
+	get_state->client_lpid = request->client_lpid;
 
 	if (gr_gst_need_update(state, get_state->gst)) {
 		cpu_lock_lock(state->cpu, state->lock, GR_GET_REQUEST_LOCKED,
@@ -147,7 +143,9 @@ void gr_process_get_request_unlocked(gr_server_state_t *state,
 		gr_get_state_message_t *state_message)
 {
 	gr_get_state_t *get_state = gr_get_state_get(state, state_message->id);
-	gr_get_response_t *response = get_state->response;
+	gr_get_response_t *response = gr_get_response_pooled(
+			state->server_state.messages);
+	response->client_lpid = get_state->client_lpid;
 	response->gst = state->gst;
 	gr_get_value(&(response->value), &(response->update_timestamp), NULL, state,
 			get_state->key);
@@ -187,7 +185,7 @@ void gr_process_put_request(gr_server_state_t *state, gr_put_request_t *request)
 	gr_put_state_t *put_state = gr_put_state_get(state, state_message.id);
 	put_state->key = request->key;
 	put_state->value = request->value;
-	put_state->response->client_lpid = request->client_lpid;
+	put_state->client_lpid = request->client_lpid;
 	put_state->destination = request->proxy_lpid == NO_PROXY_LPID
 		? request->client_lpid : request->proxy_lpid;
 	cpu_lock_lock(state->cpu, state->lock, GR_PUT_REQUEST_LOCKED,
@@ -199,7 +197,7 @@ void gr_process_put_request_locked(gr_server_state_t *state,
 {
 	gr_put_state_t *put_state = gr_put_state_get(state, state_message->id);
 	state->version_vector[state->config->replica] = state->clock;
-	put_state->response->update_timestamp = state->clock;
+	put_state->update_time = state->clock;
 	put_state->update_time_no_skew = state->now;
 	item_t *item = gr_put_value(state, put_state->key, put_state->value,
 			state->clock, state->config->replica);
@@ -223,13 +221,17 @@ void gr_process_put_request_unlocked(gr_server_state_t *state,
 		gr_put_state_message_t *state_message)
 {
 	gr_put_state_t *put_state = gr_put_state_get(state, state_message->id);
+	gr_put_response_t *response = gr_put_response_pooled(
+			state->server_state.messages);
+	response->client_lpid = put_state->client_lpid;
+	response->update_timestamp = put_state->update_time;
 	server_send(&state->server_state, put_state->destination, GR_PUT_RESPONSE,
-			&put_state->response->message);
+			&response->message);
 
 	// Do not replicate the value if it has been discarded as a result of a conflict
 	if (!put_state->discarded) {
 		gr_replicate_value(state, put_state->key, put_state->value,
-				put_state->response->update_timestamp, put_state->previous_update_time,
+				put_state->update_time, put_state->previous_update_time,
 				put_state->previous_source_replica, put_state->update_time_no_skew);
 	}
 	gr_put_state_free(state, state_message->id);
@@ -11,6 +11,7 @@
 #include "server/protocols/gr/rotx.h"
 #include "server/protocols/gr/slice.h"
 #include "server/protocols/gr/snapshot.h"
+#include "server/protocols/gr/stats.h"
 #include "server/stats.h"
 
 static DEFINE_PROTOCOL_PARAMETER_FUNC(clock_interval, double, "gr");
@@ -28,6 +29,7 @@ static void gr_init_state(server_state_t *state_)
 	state->version_vector = calloc(num_replicas, sizeof(gr_tsp));
 	state->gst = 0;
 	state->min_lst = 0;
+	state->gc_time = 0;
 	state->lst_received = calloc(state->config->tree_fanout, sizeof(int));
 	state->forwarded_get_id = server_stats_counter_new(&state->server_state,
 			"forwarded get requests");
@@ -37,19 +39,36 @@ static void gr_init_state(server_state_t *state_)
 	ptr_array_init(&state->get_states);
 	ptr_array_init(&state->put_states);
 	ptr_array_init(&state->snapshot_states);
+	state->slice_key_ends = malloc(state->config->cluster->num_partitions
+			* sizeof(unsigned int));
+	state->slice_key_order = NULL;
+	state->slice_key_order_size = 0;
 	ptr_array_init(&state->rotx_states);
+	min_heap_init(&state->rotxs_waiting_gst);
 
 	state->replica_locks = malloc(num_replicas * sizeof(cpu_lock_id_t));
 	for (unsigned int i = 0; i < num_replicas; ++i) {
 		state->replica_locks[i] = cpu_lock_new(state->cpu);
 	}
 
-	state->replica_update_queues = malloc(num_replicas * sizeof(queue_t*));
-	for (unsigned int i = 0; i < num_replicas; ++i) {
-		state->replica_update_queues[i] = queue_new();
-	}
+	gr_replication_init(state);
+	state->free_items = NULL;
+	ring_buffer_init(&state->gc_keys, sizeof(gr_key));
+
+	gr_stats_init(state);
 
-	if (server_is_leaf_partition(&state->server_state)) {
+	state->partition_lsts = NULL;
+	state->partition_gsts = NULL;
+	state->previous_partition_gsts = NULL;
+	if (state->config->gst_topology == GST_TOPOLOGY_BROADCAST) {
+		state->partition_lsts = calloc(state->config->cluster->num_partitions,
+				sizeof(gr_tsp));
+		state->partition_gsts = calloc(state->config->cluster->num_partitions,
+				sizeof(gr_tsp));
+		state->previous_partition_gsts = calloc(
+				state->config->cluster->num_partitions, sizeof(gr_tsp));
+		gr_schedule_gst_computation_start(state);
+	} else if (server_is_leaf_partition(&state->server_state)) {
 		gr_schedule_gst_computation_start(state);
 	}
 
@@ -136,6 +155,24 @@ static int gr_process_event(server_state_t *state_, unsigned int event_type,
 		case GR_REPLICA_UPDATE_UNLOCKED:
 			gr_process_replica_update_unlocked(state, data);
 			break;
+		case GR_REPLICA_UPDATE_PARALLEL_LOCKED:
+			gr_process_replica_update_parallel_locked(state, data);
+			break;
+		case GR_REPLICA_UPDATE_PARALLEL_UNLOCKED:
+			gr_process_replica_update_parallel_unlocked(state, data);
+			break;
+		case GR_REPLICA_UPDATE_BATCH:
+			gr_process_replica_update_batch(state, data);
+			break;
+		case GR_REPLICA_UPDATE_BATCH_LOCKED:
+			gr_process_replica_update_batch_locked(state, data);
+			break;
+		case GR_REPLICA_UPDATE_BATCH_UNLOCKED:
+			gr_process_replica_update_batch_unlocked(state, data);
+			break;
+		case GR_REPLICATION_BATCH_TIMEOUT:
+			gr_process_replication_batch_timeout(state, data);
+			break;
 		case GR_LST_FROM_LEAF:
 			gr_process_lst_from_leaf(state, data);
 			break;
@@ -157,6 +194,12 @@ static int gr_process_event(server_state_t *state_, unsigned int event_type,
 		case GR_START_GST_COMPUTATION:
 			gr_process_start_gst_computation(state);
 			break;
+		case GR_LST_BROADCAST:
+			gr_process_lst_broadcast(state, data);
+			break;
+		case GR_LST_BROADCAST_LOCKED:
+			gr_process_lst_broadcast_locked(state);
+			break;
 		case GR_CLOCK_TICK:
 			gr_process_clock_tick(state);
 			break;
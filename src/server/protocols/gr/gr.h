@@ -3,16 +3,17 @@
 
 #include "cpu/lock.h"
 #include "messages/gr.h"
+#include "min_heap.h"
 #include "protocols.h"
 #include "ptr_array.h"
-#include "queue.h"
+#include "ring_buffer.h"
 #include "server/server.h"
 
 typedef struct {
 	lpid_t client_lpid;
 	gr_tsp dependency_time;
+	int ready; // Released by a GST update, see rotx.c
 	gr_get_snapshot_request_t *snapshot_request;
-	int waiting_gst;
 } gr_rotx_state_t;
 
 typedef struct {
@@ -23,6 +24,10 @@ typedef struct {
 	gr_tsp *version_vector; // Physical timestamps from each replicas
 	gr_tsp gst;
 	gr_tsp min_lst;
+	gr_tsp *partition_lsts; // Broadcast GST topology only, see gst.c
+	gr_tsp *partition_gsts; // Broadcast GST topology only
+	gr_tsp *previous_partition_gsts; // Broadcast GST topology only
+	gr_tsp gc_time; // Lower bound of the snapshot times, see store.c
 	int *lst_received;
 	unsigned int forwarded_get_id;
 	unsigned int forwarded_put_id;
@@ -30,9 +35,26 @@ typedef struct {
 	ptr_array_t get_states;
 	ptr_array_t put_states;
 	ptr_array_t snapshot_states;
+	unsigned int *slice_key_ends; // Per partition, see snapshot.c
+	unsigned int *slice_key_order; // See snapshot.c
+	unsigned int slice_key_order_size;
 	ptr_array_t rotx_states;
+	min_heap_t rotxs_waiting_gst; // Ordered by dependency time
 	cpu_lock_id_t *replica_locks;
-	queue_t **replica_update_queues;
+	ring_buffer_t *replica_update_queues; // Per source replica, by value
+	ring_buffer_t *replica_batch_queues; // Per source replica, see replication.c
+	ring_buffer_t *replica_update_states; // Parallel apply, see replication.c
+	unsigned int *replica_update_heads; // Parallel apply, sequence numbers
+	gr_tsp *pending_heartbeats; // Parallel apply, see replication.c
+	cpu_lock_id_t *replica_key_locks; // Parallel apply, by key
+	store_t **replica_pending_keys; // Parallel apply, see replication.c
+	gr_replica_update_entry_t *replication_batch; // See replication.c
+	unsigned int replication_batch_count;
+	unsigned int replication_batch_id; // Incremented by each flush
+	gr_tsp replicated_time; // Latest time sent to the other replicas
+	ring_buffer_t *pending_visibility; // Per source replica, see stats.c
+	struct item *free_items; // Recycled versions, see store.c
+	ring_buffer_t gc_keys; // Keys with old versions, see store.c
 } gr_server_state_t;
 
 #ifdef server_protocols_gr_gr_c
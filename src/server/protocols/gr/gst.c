@@ -63,9 +63,6 @@ void gr_process_lst_from_leaf(gr_server_state_t *state, gr_lst_from_leaf_t *leaf
 		} else {
 			gr_send_lst_to_parent(state);
 		}
-		// FIXME Currently garbage collection doesn't take cpu time
-		// FIXME Garbage collection is currently disabled as it takes too much real time
-		//garbage_collect(state);
 	}
 }
 
@@ -81,39 +78,22 @@ void gr_process_lst_from_leaf_root_unlocked(gr_server_state_t *state)
 	gr_send_gst_to_children(state);
 }
 
-struct gr_send_gst_data {
-	gr_server_state_t *state;
-	gr_gst_from_root_t *root_gst;
-};
-
-static void gr_send_gst(partition_t partition, void *data_)
-	{
-		struct gr_send_gst_data * data = (struct gr_send_gst_data *) data_;
-		gr_server_state_t *state = data->state;
-		lpid_t child_lpid = cluster_get_lpid(state->config->cluster,
-				state->config->replica, partition);
-		server_send(&state->server_state, child_lpid, GR_GST_FROM_ROOT,
-				&data->root_gst->message);
-	}
-
 void gr_send_gst_to_children(gr_server_state_t *state)
 {
-	gr_gst_from_root_t *root_gst = gr_gst_from_root_new();
+	gr_gst_from_root_t *root_gst = gr_gst_from_root_pooled(
+			state->server_state.messages);
 	root_gst->gst = state->gst;
 	cpu_add_time(state->cpu, build_struct_per_byte_time()
 			* (simtime_t) root_gst->simulated_size);
-	struct gr_send_gst_data data = {
-		.state = state,
-		.root_gst = root_gst,
-	};
-	server_foreach_children_partition(&state->server_state, gr_send_gst, &data);
-	free(root_gst);
+	server_multicast(&state->server_state, state->config->children_lpids,
+			state->config->num_children, GR_GST_FROM_ROOT, &root_gst->message);
 }
 
 void gr_send_lst_to_parent(gr_server_state_t *state)
 {
 	assert(state->config->partition != 0);
-	gr_lst_from_leaf_t *leaf_lst = gr_lst_from_leaf_new();
+	gr_lst_from_leaf_t *leaf_lst = gr_lst_from_leaf_pooled(
+			state->server_state.messages);
 	leaf_lst->lst = state->min_lst;
 	leaf_lst->leaf_partition_id = state->config->partition;
 	cpu_add_time(state->cpu, build_struct_per_byte_time()
@@ -121,12 +101,8 @@ void gr_send_lst_to_parent(gr_server_state_t *state)
 	for (unsigned int i = 0; i < state->config->tree_fanout; ++i) {
 		state->lst_received[i] = 0;
 	}
-	unsigned int parent_partition = server_parent_partition_id(&state->server_state);
-	lpid_t parent_lpid = cluster_get_lpid(state->config->cluster,
-			state->config->replica, parent_partition);
-	server_send(&state->server_state, parent_lpid, GR_LST_FROM_LEAF,
-			&leaf_lst->message);
-	free(leaf_lst);
+	server_send(&state->server_state, state->config->parent_lpid,
+			GR_LST_FROM_LEAF, &leaf_lst->message);
 }
 
 void gr_schedule_gst_computation_start(gr_server_state_t *state)
@@ -145,8 +121,6 @@ void gr_process_gst_from_root_locked(gr_server_state_t *state,
 		gr_gst_from_root_t *root_gst)
 {
 	gr_update_gst(state, root_gst->gst);
-	//FIXME See above FIXME near line 63
-	//garbage_collect(state);
 	cpu_lock_unlock(state->cpu, state->lock, GR_GST_FROM_ROOT_UNLOCKED,
 			root_gst, root_gst->size);
 }
@@ -158,16 +132,88 @@ void gr_process_gst_from_root_unlocked(gr_server_state_t *state,
 		cpu_allow_no_time(state->cpu);
 		gr_schedule_gst_computation_start(state);
 	} else {
-		struct gr_send_gst_data data = {
-			.state = state,
-			.root_gst = root_gst,
-		};
-		server_foreach_children_partition(&state->server_state, gr_send_gst, &data);
+		server_multicast(&state->server_state, state->config->children_lpids,
+				state->config->num_children, GR_GST_FROM_ROOT,
+				&root_gst->message);
+	}
+}
+
+// With the broadcast topology, each partition sends its LST to all the other
+// partitions of its replica and computes the GST on its own from the latest
+// LST received from each of them.
+static void gr_update_gst_from_partition_lsts(gr_server_state_t *state)
+{
+	gr_tsp min_lst = state->partition_lsts[0];
+	gr_tsp gc_time = state->previous_partition_gsts[0];
+	for (partition_t p = 1; p < state->config->cluster->num_partitions; ++p) {
+		set_min(&min_lst, state->partition_lsts[p]);
+		set_min(&gc_time, state->previous_partition_gsts[p]);
 	}
+	cpu_add_time(state->cpu, process_lst_from_leaf_end_per_replica_time());
+	set_max(&state->gc_time, gc_time);
+	if (gr_gst_need_update(state, min_lst)) {
+		state->min_lst = min_lst;
+		cpu_lock_lock(state->cpu, state->lock, GR_LST_BROADCAST_LOCKED, NULL, 0);
+	}
+}
+
+// Each partition also sends its GST along with its LST. The snapshot times of
+// the slice requests sent by a partition are at least its GST, but requests
+// built before its latest GST was sent may still be in flight, so garbage
+// collection stays below the GST it sent before that one.
+static void set_partition_times(gr_server_state_t *state,
+		partition_t partition, gr_tsp lst, gr_tsp gst)
+{
+	set_max(&state->partition_lsts[partition], lst);
+	if (state->partition_gsts[partition] < gst) {
+		state->previous_partition_gsts[partition] =
+			state->partition_gsts[partition];
+		state->partition_gsts[partition] = gst;
+	}
+}
+
+static void gr_broadcast_lst(gr_server_state_t *state)
+{
+	partition_t partition = state->config->partition;
+	set_partition_times(state, partition, min_replica_version(state),
+			state->gst);
+	gr_schedule_gst_computation_start(state);
+
+	gr_lst_broadcast_t *lst = gr_lst_broadcast_pooled(
+			state->server_state.messages);
+	lst->lst = state->partition_lsts[partition];
+	lst->gst = state->gst;
+	lst->partition_id = partition;
+	cpu_add_time(state->cpu, build_struct_per_byte_time()
+			* (simtime_t) lst->simulated_size);
+	server_multicast(&state->server_state, state->config->partition_peers,
+			state->config->num_partition_peers, GR_LST_BROADCAST,
+			&lst->message);
+
+	gr_update_gst_from_partition_lsts(state);
+}
+
+void gr_process_lst_broadcast(gr_server_state_t *state, gr_lst_broadcast_t *lst)
+{
+	cpu_add_time(state->cpu, process_lst_from_leaf_per_replica_time());
+	set_partition_times(state, lst->partition_id, lst->lst, lst->gst);
+	gr_update_gst_from_partition_lsts(state);
+}
+
+void gr_process_lst_broadcast_locked(gr_server_state_t *state)
+{
+	// min_lst may have increased since the lock was requested, it is still a
+	// lower bound of the LST of every partition
+	gr_update_gst(state, state->min_lst);
+	cpu_lock_unlock(state->cpu, state->lock, CPU_NO_EVENT, NULL, 0);
 }
 
 void gr_process_start_gst_computation(gr_server_state_t *state)
 {
+	if (state->config->gst_topology == GST_TOPOLOGY_BROADCAST) {
+		gr_broadcast_lst(state);
+		return;
+	}
 	assert(server_is_leaf_partition(&state->server_state));
 	if (state->config->partition == 0) {
 		// Only one partition
@@ -175,17 +221,14 @@ void gr_process_start_gst_computation(gr_server_state_t *state)
 		gr_schedule_gst_computation_start(state);
 		return;
 	}
-	gr_lst_from_leaf_t *leaf_lst = gr_lst_from_leaf_new();
+	gr_lst_from_leaf_t *leaf_lst = gr_lst_from_leaf_pooled(
+			state->server_state.messages);
 	leaf_lst->lst = min_replica_version(state);
 	leaf_lst->leaf_partition_id = state->config->partition;
 	cpu_add_time(state->cpu, build_struct_per_byte_time()
 			* (simtime_t) leaf_lst->simulated_size);
-	lpid_t parent_lpid = cluster_get_lpid(
-			state->config->cluster, state->config->replica,
-			server_parent_partition_id(&state->server_state));
-	server_send(&state->server_state, parent_lpid, GR_LST_FROM_LEAF,
-			&leaf_lst->message);
-	free(leaf_lst);
+	server_send(&state->server_state, state->config->parent_lpid,
+			GR_LST_FROM_LEAF, &leaf_lst->message);
 }
 
 int gr_gst_need_update(gr_server_state_t *state, gr_tsp gst)
@@ -199,7 +242,13 @@ void gr_update_gst(gr_server_state_t *state, gr_tsp gst)
 	cpu_add_time(state->cpu, update_gst_time());
 	if (state->gst < gst) {
 		gr_stats_gst_update(state, state->gst, gst);
+		if (state->config->gst_topology != GST_TOPOLOGY_BROADCAST) {
+			// The root computes a GST once all the partitions got the
+			// previous one, none of them has a GST below the one replaced
+			state->gc_time = state->gst;
+		}
 		state->gst = gst;
 		gr_rotx_on_gst_updated(state);
+		gr_garbage_collect(state);
 	}
 }
@@ -17,6 +17,8 @@ void gr_process_gst_from_root_locked(gr_server_state_t *state,
 		gr_gst_from_root_t *root_gst);
 void gr_process_gst_from_root_unlocked(gr_server_state_t *state,
 		gr_gst_from_root_t *root_gst);
+void gr_process_lst_broadcast(gr_server_state_t *state, gr_lst_broadcast_t *lst);
+void gr_process_lst_broadcast_locked(gr_server_state_t *state);
 void gr_process_start_gst_computation(gr_server_state_t *state);
 void gr_schedule_gst_computation_start(gr_server_state_t *state);
 void gr_send_gst_to_children(gr_server_state_t *state);
@@ -4,7 +4,11 @@
 #include "event.h"
 #include "gentle_rain.h"
 #include "parameters.h"
+#include "server/protocols/gr/replication.h"
 
+static DEFINE_PROTOCOL_PARAMETER_DEFAULT_FUNC(replication_batch_size, uint, "gr", 0);
+static DEFINE_PROTOCOL_PARAMETER_DEFAULT_FUNC(parallel_replica_update_locks, uint, "gr", 0);
+static DEFINE_PROTOCOL_PARAMETER_DEFAULT_FUNC(suppress_redundant_heartbeats, uint, "gr", 0);
 static DEFINE_PROTOCOL_TIMING_FUNC(process_heartbeat_time, "gr");
 
 static size_t gr_heartbeat_size(gr_heartbeat_t *heartbeat)
@@ -25,7 +29,13 @@ void gr_process_heartbeat(gr_server_state_t *state, gr_heartbeat_t *heartbeat)
 void gr_process_heartbeat_locked(gr_server_state_t *state, gr_heartbeat_t *heartbeat)
 {
 	cpu_add_time(state->cpu, process_heartbeat_time());
-	if (state->version_vector[heartbeat->replica] < heartbeat->time) {
+	if (parallel_replica_update_locks() > 0 && !ring_buffer_is_empty(
+				&state->replica_update_queues[heartbeat->replica])) {
+		// Updates sent before the heartbeat are still being applied, the
+		// version vector is advanced once they are, see replication.c
+		set_max(&state->pending_heartbeats[heartbeat->replica],
+				heartbeat->time);
+	} else if (state->version_vector[heartbeat->replica] < heartbeat->time) {
 		state->version_vector[heartbeat->replica] = heartbeat->time;
 	}
 	cpu_lock_unlock(state->cpu, state->replica_locks[heartbeat->replica],
@@ -34,19 +44,32 @@ void gr_process_heartbeat_locked(gr_server_state_t *state, gr_heartbeat_t *heart
 
 void gr_send_heartbeat(gr_server_state_t *state, int send_time)
 {
-	gr_heartbeat_t *heartbeat = gr_heartbeat_new();
+	gr_tsp time = send_time ? state->clock : 0;
+	if (suppress_redundant_heartbeats() != 0
+			&& time <= state->replicated_time
+			&& state->replication_batch_count == 0) {
+		// The other replicas already advanced their version vector up to
+		// this time with an update or a previous heartbeat
+		cpu_allow_no_time(state->cpu);
+		return;
+	}
+
+	if (replication_batch_size() > 0) {
+		// Batches are ordered with the updates they follow, the buffered
+		// updates are sent along with the heartbeat
+		gr_flush_replication_batch(state, time);
+		return;
+	}
+
+	gr_heartbeat_t *heartbeat = gr_heartbeat_pooled(
+			state->server_state.messages);
 	heartbeat->replica = state->config->replica;
-	heartbeat->time = send_time ? state->clock : 0;
+	heartbeat->time = time;
+	set_max(&state->replicated_time, time);
 	cpu_add_time(state->cpu, build_struct_per_byte_time()
 			* (simtime_t) heartbeat->simulated_size);
 
-	void send_heartbeat_message(lpid_t replica_lpid, replica_t replica) {
-		if (replica == state->config->replica) return;
-		server_send(&state->server_state, replica_lpid, GR_HEARTBEAT,
-				&heartbeat->message);
-	}
-	foreach_replica(state->config->cluster,
-			state->config->partition, send_heartbeat_message);
-
-	free(heartbeat);
+	server_multicast(&state->server_state, state->config->replica_peers,
+			state->config->num_replica_peers, GR_HEARTBEAT,
+			&heartbeat->message);
 }
@@ -1,63 +1,164 @@
 #include "server/protocols/gr/replication.h"
 #include "event.h"
 #include "parameters.h"
-#include "queue.h"
 #include "server/protocols/gr/store.h"
 #include "server/stats.h"
 #include <assert.h>
 
+static DEFINE_PROTOCOL_PARAMETER_DEFAULT_FUNC(replication_batch_size, uint, "gr", 0);
+static DEFINE_PROTOCOL_PARAMETER_DEFAULT_FUNC(replication_batch_interval, double, "gr", 0);
+static DEFINE_PROTOCOL_PARAMETER_DEFAULT_FUNC(parallel_replica_update_locks, uint, "gr", 0);
+static DEFINE_PROTOCOL_TIMING_FUNC(process_heartbeat_time, "gr");
 static DEFINE_PROTOCOL_TIMING_FUNC(process_replica_update_time, "gr");
 
+// Time and number of updates of a received batch, the updates themselves are
+// in the update queue of the source replica
+typedef struct {
+	unsigned int num_updates;
+	gr_tsp time;
+} batch_header_t;
+
+// Progress of the updates queued for parallel apply
+enum {
+	UPDATE_WAITING, // An older update to the same key is not applied yet
+	UPDATE_DISPATCHED,
+	UPDATE_APPLIED,
+};
+
+typedef struct {
+	unsigned char state;
+	unsigned int next_waiting; // Sequence number, see pending_key_t
+} update_progress_t;
+
+// Updates to a key from a source replica are applied one at a time, in
+// order. The waiting ones are linked by their next_waiting field.
+typedef struct {
+	int dispatched; // Whether an update is dispatched and not applied yet
+	unsigned int num_waiting;
+	unsigned int first_waiting; // Sequence numbers
+	unsigned int last_waiting;
+} pending_key_t;
+
+void gr_replication_init(gr_server_state_t *state)
+{
+	state->replication_batch = replication_batch_size() == 0 ? NULL
+		: malloc(replication_batch_size() * sizeof(gr_replica_update_entry_t));
+	state->replication_batch_count = 0;
+	state->replication_batch_id = 0;
+	state->replicated_time = 0;
+
+	unsigned int num_replicas = state->config->cluster->num_replicas;
+	state->replica_update_queues = malloc(num_replicas * sizeof(ring_buffer_t));
+	state->replica_batch_queues = malloc(num_replicas * sizeof(ring_buffer_t));
+	for (unsigned int i = 0; i < num_replicas; ++i) {
+		ring_buffer_init(&state->replica_update_queues[i],
+				sizeof(gr_replica_update_entry_t));
+		ring_buffer_init(&state->replica_batch_queues[i],
+				sizeof(batch_header_t));
+	}
+
+	unsigned int num_key_locks = parallel_replica_update_locks();
+	if (num_key_locks > 0) {
+		state->replica_update_states =
+			malloc(num_replicas * sizeof(ring_buffer_t));
+		state->replica_update_heads = calloc(num_replicas, sizeof(unsigned int));
+		state->pending_heartbeats = calloc(num_replicas, sizeof(gr_tsp));
+		state->replica_pending_keys = malloc(num_replicas * sizeof(store_t*));
+		for (unsigned int i = 0; i < num_replicas; ++i) {
+			ring_buffer_init(&state->replica_update_states[i],
+					sizeof(update_progress_t));
+			state->replica_pending_keys[i] = store_new();
+		}
+		state->replica_key_locks = malloc(num_key_locks * sizeof(cpu_lock_id_t));
+		for (unsigned int i = 0; i < num_key_locks; ++i) {
+			state->replica_key_locks[i] = cpu_lock_new(state->cpu);
+		}
+	}
+}
+
+// Whether an update conflicting with the latest local version is older
+// than it and must be ignored
+static int is_overwritten_update(gr_server_state_t *state, gr_key key,
+		gr_tsp update_time, replica_t update_source_replica,
+		gr_tsp previous_update_time, replica_t previous_source_replica)
+{
+	gr_value value;
+	gr_tsp local_update_time;
+	replica_t source_replica;
+	gr_get_value_at(&value, &local_update_time, &source_replica,
+			state, key, 0, gr_always_visible);
+	if (previous_update_time == local_update_time
+			&& previous_source_replica == source_replica) {
+		return 0;
+	}
+	if (update_time < local_update_time ||
+			(update_time == local_update_time
+			 && update_source_replica < source_replica)) {
+		assert(update_source_replica != source_replica);
+		return 1;
+	}
+	return 0;
+}
+
 static void gr_process_replica_update_work(gr_server_state_t *state,
-		gr_replica_update_t *update);
+		replica_t source_replica);
+static void gr_process_replica_update_parallel(gr_server_state_t *state,
+		replica_t source_replica, gr_replica_update_entry_t *update);
 
 void gr_process_replica_update(gr_server_state_t *state, gr_replica_update_t *update)
 {
-	queue_t *queue = state->replica_update_queues[update->source_replica];
-	int process_immediately = queue_is_empty(queue);
-	gr_replica_update_t *enqueued_update = malloc(update->size);
-	memcpy(enqueued_update, update, update->size);
-	queue_enqueue(queue, enqueued_update);
+	ring_buffer_t *queue = &state->replica_update_queues[update->source_replica];
+	int process_immediately = ring_buffer_is_empty(queue);
+	gr_replica_update_entry_t entry = {
+		.key = update->key,
+		.value = update->value,
+		.update_time = update->update_time,
+		.update_time_no_skew = update->update_time_no_skew,
+		.previous_update_time = update->previous_update_time,
+		.previous_source_replica = update->previous_source_replica,
+	};
+	if (parallel_replica_update_locks() > 0) {
+		gr_process_replica_update_parallel(state, update->source_replica,
+				&entry);
+		return;
+	}
+	ring_buffer_push(queue, &entry);
 	if (process_immediately) {
-		gr_process_replica_update_work(state, update);
+		gr_process_replica_update_work(state, update->source_replica);
 	} else {
 		cpu_allow_no_time(state->cpu);
 	}
 }
 
+// Process the update at the head of the queue of the source replica, it
+// stays there until unlocked
 static void gr_process_replica_update_work(gr_server_state_t *state,
-		gr_replica_update_t *update)
+		replica_t source_replica)
 {
-	assert(update->source_replica != state->config->replica);
+	assert(source_replica != state->config->replica);
+	gr_replica_update_entry_t *update =
+		ring_buffer_peek(&state->replica_update_queues[source_replica]);
 	cpu_add_time(state->cpu, process_replica_update_time());
 
-	// Conflict detection
-	gr_value value;
-	gr_tsp update_time;
-	replica_t source_replica;
-	gr_get_value_at(&value, &update_time, &source_replica,
-			state, update->key, 0, gr_always_visible);
-	if (update->previous_update_time != update_time
-			|| update->previous_source_replica != source_replica) {
-		// There is a conflict, ignore the update if it is older
-		if (update->update_time < update_time ||
-				(update->update_time == update_time
-				 && update->source_replica < source_replica)) {
-			assert(update->source_replica != source_replica);
-			gr_process_replica_update_unlocked(state, update);
-		}
+	// Conflict detection, the update is ignored if it is older
+	if (is_overwritten_update(state, update->key, update->update_time,
+				source_replica, update->previous_update_time,
+				update->previous_source_replica)) {
+		gr_process_replica_update_unlocked(state, &source_replica);
 	} else {
-		cpu_lock_lock(state->cpu, state->replica_locks[update->source_replica],
-				GR_REPLICA_UPDATE_LOCKED, update, update->size);
+		cpu_lock_lock(state->cpu, state->replica_locks[source_replica],
+				GR_REPLICA_UPDATE_LOCKED, &source_replica, sizeof(replica_t));
 	}
 }
 
 void gr_process_replica_update_locked(gr_server_state_t *state,
-		gr_replica_update_t *update)
+		replica_t *source_replica)
 {
-
-	gr_put_value(state, update->key, update->value, update->update_time, update->source_replica);
-	state->version_vector[update->source_replica] = update->update_time;
+	gr_replica_update_entry_t *update =
+		ring_buffer_peek(&state->replica_update_queues[*source_replica]);
+	gr_put_value(state, update->key, update->value, update->update_time,
+			*source_replica);
+	state->version_vector[*source_replica] = update->update_time;
 
 	server_stats_counter_inc(&state->server_state, REPLICA_UPDATES);
 	// Don't use skewed clocks to compute statistics
@@ -66,35 +167,328 @@ void gr_process_replica_update_locked(gr_server_state_t *state,
 	server_stats_array_push(&state->server_state, REPLICATION_TIME,
 			replication_time);
 
-	cpu_lock_unlock(state->cpu, state->replica_locks[update->source_replica],
-			GR_REPLICA_UPDATE_UNLOCKED, update, update->size);
+	cpu_lock_unlock(state->cpu, state->replica_locks[*source_replica],
+			GR_REPLICA_UPDATE_UNLOCKED, source_replica, sizeof(replica_t));
 }
 
 void gr_process_replica_update_unlocked(gr_server_state_t *state,
-		gr_replica_update_t *update)
-{
-	queue_t *queue = state->replica_update_queues[update->source_replica];
-	gr_replica_update_t *enqueued_update = queue_dequeue(queue);
-	assert(enqueued_update != NULL);
-	assert(enqueued_update->key == update->key);
-	assert(enqueued_update->value == update->value);
-	assert(enqueued_update->update_time == update->update_time);
-	assert(enqueued_update->source_replica == update->source_replica);
-	free(enqueued_update);
-
-	enqueued_update = queue_peek(queue);
-	if (enqueued_update != NULL) {
-		gr_process_replica_update_work(state, enqueued_update);
+		replica_t *source_replica)
+{
+	ring_buffer_t *queue = &state->replica_update_queues[*source_replica];
+	ring_buffer_shift(queue);
+	if (!ring_buffer_is_empty(queue)) {
+		gr_process_replica_update_work(state, *source_replica);
+	} else {
+		cpu_allow_no_time(state->cpu);
+	}
+}
+
+static void gr_process_replica_update_parallel_work(gr_server_state_t *state,
+		gr_replica_update_ref_t *ref)
+{
+	cpu_add_time(state->cpu, process_replica_update_time());
+	cpu_lock_lock(state->cpu,
+			state->replica_key_locks[ref->key % parallel_replica_update_locks()],
+			GR_REPLICA_UPDATE_PARALLEL_LOCKED, ref, sizeof(*ref));
+}
+
+static update_progress_t *update_progress(gr_server_state_t *state,
+		replica_t source_replica, unsigned int sequence_number)
+{
+	return ring_buffer_get(&state->replica_update_states[source_replica],
+			sequence_number - state->replica_update_heads[source_replica]);
+}
+
+static pending_key_t *pending_key(gr_server_state_t *state,
+		replica_t source_replica, gr_key key)
+{
+	store_t *pending_keys = state->replica_pending_keys[source_replica];
+	pending_key_t *pending = store_get(pending_keys, key);
+	if (pending == NULL) {
+		pending = malloc(sizeof(pending_key_t));
+		pending->dispatched = 0;
+		pending->num_waiting = 0;
+		store_put(pending_keys, key, pending);
+	}
+	return pending;
+}
+
+// Queue an update and start applying it right away unless an older update to
+// the same key from the same replica is still pending
+static void gr_process_replica_update_parallel(gr_server_state_t *state,
+		replica_t source_replica, gr_replica_update_entry_t *update)
+{
+	assert(source_replica != state->config->replica);
+	ring_buffer_t *queue = &state->replica_update_queues[source_replica];
+	gr_replica_update_ref_t ref = {
+		.source_replica = source_replica,
+		.sequence_number = state->replica_update_heads[source_replica]
+			+ ring_buffer_size(queue),
+		.key = update->key,
+	};
+	ring_buffer_push(queue, update);
+	update_progress_t progress = {
+		.state = UPDATE_DISPATCHED,
+	};
+	pending_key_t *pending = pending_key(state, source_replica, update->key);
+	if (pending->dispatched || pending->num_waiting > 0) {
+		progress.state = UPDATE_WAITING;
+		if (pending->num_waiting == 0) {
+			pending->first_waiting = ref.sequence_number;
+		} else {
+			update_progress(state, source_replica,
+					pending->last_waiting)->next_waiting = ref.sequence_number;
+		}
+		pending->last_waiting = ref.sequence_number;
+		++pending->num_waiting;
+	} else {
+		pending->dispatched = 1;
+	}
+	ring_buffer_push(&state->replica_update_states[source_replica], &progress);
+	if (progress.state == UPDATE_DISPATCHED) {
+		gr_process_replica_update_parallel_work(state, &ref);
 	} else {
 		cpu_allow_no_time(state->cpu);
 	}
 }
 
+void gr_process_replica_update_parallel_locked(gr_server_state_t *state,
+		gr_replica_update_ref_t *ref)
+{
+	replica_t source_replica = ref->source_replica;
+	ring_buffer_t *queue = &state->replica_update_queues[source_replica];
+	ring_buffer_t *update_states = &state->replica_update_states[source_replica];
+	unsigned int index =
+		ref->sequence_number - state->replica_update_heads[source_replica];
+	gr_replica_update_entry_t *update = ring_buffer_get(queue, index);
+	assert(update->key == ref->key);
+
+	// The conflict detection happens here as older updates to the same key
+	// are only applied at this point
+	if (!is_overwritten_update(state, update->key, update->update_time,
+				source_replica, update->previous_update_time,
+				update->previous_source_replica)) {
+		gr_put_value(state, update->key, update->value, update->update_time,
+				source_replica);
+
+		server_stats_counter_inc(&state->server_state, REPLICA_UPDATES);
+		simtime_t replication_time = state->now - update->update_time_no_skew;
+		assert(replication_time > 0);
+		server_stats_array_push(&state->server_state, REPLICATION_TIME,
+				replication_time);
+	}
+	((update_progress_t*) ring_buffer_get(update_states, index))->state =
+		UPDATE_APPLIED;
+	pending_key(state, source_replica, ref->key)->dispatched = 0;
+
+	// The version vector only covers updates whose predecessors are all
+	// applied
+	while (!ring_buffer_is_empty(queue)
+			&& ((update_progress_t*) ring_buffer_peek(update_states))->state
+				== UPDATE_APPLIED) {
+		update = ring_buffer_peek(queue);
+		set_max(&state->version_vector[source_replica], update->update_time);
+		ring_buffer_shift(queue);
+		ring_buffer_shift(update_states);
+		++state->replica_update_heads[source_replica];
+	}
+	// A heartbeat received while updates were pending only covers them
+	// once they are all applied
+	if (ring_buffer_is_empty(queue)) {
+		set_max(&state->version_vector[source_replica],
+				state->pending_heartbeats[source_replica]);
+	}
+
+	cpu_lock_unlock(state->cpu,
+			state->replica_key_locks[ref->key % parallel_replica_update_locks()],
+			GR_REPLICA_UPDATE_PARALLEL_UNLOCKED, ref, sizeof(*ref));
+}
+
+// Start applying the next update to the same key, if any
+void gr_process_replica_update_parallel_unlocked(gr_server_state_t *state,
+		gr_replica_update_ref_t *ref)
+{
+	pending_key_t *pending = pending_key(state, ref->source_replica, ref->key);
+	if (pending->num_waiting == 0) {
+		cpu_allow_no_time(state->cpu);
+		return;
+	}
+	gr_replica_update_ref_t next = {
+		.source_replica = ref->source_replica,
+		.sequence_number = pending->first_waiting,
+		.key = ref->key,
+	};
+	update_progress_t *progress = update_progress(state, ref->source_replica,
+			next.sequence_number);
+	assert(progress->state == UPDATE_WAITING);
+	progress->state = UPDATE_DISPATCHED;
+	pending->first_waiting = progress->next_waiting;
+	--pending->num_waiting;
+	pending->dispatched = 1;
+	gr_process_replica_update_parallel_work(state, &next);
+}
+
+static void gr_process_replica_update_batch_work(gr_server_state_t *state,
+		replica_t source_replica);
+
+void gr_process_replica_update_batch(gr_server_state_t *state,
+		gr_replica_update_batch_t *batch)
+{
+	ring_buffer_t *queue = &state->replica_batch_queues[batch->source_replica];
+	int process_immediately = ring_buffer_is_empty(queue);
+	gr_replica_update_entry_t *updates = gr_replica_update_batch_updates(batch);
+	for (unsigned int i = 0; i < batch->num_updates; ++i) {
+		ring_buffer_push(&state->replica_update_queues[batch->source_replica],
+				&updates[i]);
+	}
+	batch_header_t header = {
+		.num_updates = batch->num_updates,
+		.time = batch->time,
+	};
+	ring_buffer_push(queue, &header);
+	if (process_immediately) {
+		gr_process_replica_update_batch_work(state, batch->source_replica);
+	} else {
+		cpu_allow_no_time(state->cpu);
+	}
+}
+
+static void gr_process_replica_update_batch_work(gr_server_state_t *state,
+		replica_t source_replica)
+{
+	assert(source_replica != state->config->replica);
+	batch_header_t *batch =
+		ring_buffer_peek(&state->replica_batch_queues[source_replica]);
+	cpu_add_time(state->cpu, process_heartbeat_time());
+	if (batch->num_updates > 0
+			|| state->version_vector[source_replica] < batch->time) {
+		cpu_lock_lock(state->cpu, state->replica_locks[source_replica],
+				GR_REPLICA_UPDATE_BATCH_LOCKED, &source_replica,
+				sizeof(replica_t));
+	} else {
+		gr_process_replica_update_batch_unlocked(state, &source_replica);
+	}
+}
+
+// The whole batch is applied under a single acquisition of the lock of its
+// source replica. As updates are sent in order, the time of the batch then
+// also acts as a heartbeat.
+void gr_process_replica_update_batch_locked(gr_server_state_t *state,
+		replica_t *source_replica)
+{
+	ring_buffer_t *updates = &state->replica_update_queues[*source_replica];
+	batch_header_t *batch =
+		ring_buffer_peek(&state->replica_batch_queues[*source_replica]);
+	for (unsigned int i = 0; i < batch->num_updates; ++i) {
+		gr_replica_update_entry_t *update = ring_buffer_get(updates, i);
+		cpu_add_time(state->cpu, process_replica_update_time());
+		if (is_overwritten_update(state, update->key, update->update_time,
+					*source_replica, update->previous_update_time,
+					update->previous_source_replica)) {
+			continue;
+		}
+		gr_put_value(state, update->key, update->value, update->update_time,
+				*source_replica);
+
+		server_stats_counter_inc(&state->server_state, REPLICA_UPDATES);
+		simtime_t replication_time = state->now - update->update_time_no_skew;
+		assert(replication_time > 0);
+		server_stats_array_push(&state->server_state, REPLICATION_TIME,
+				replication_time);
+	}
+	set_max(&state->version_vector[*source_replica], batch->time);
+
+	cpu_lock_unlock(state->cpu, state->replica_locks[*source_replica],
+			GR_REPLICA_UPDATE_BATCH_UNLOCKED, source_replica, sizeof(replica_t));
+}
+
+void gr_process_replica_update_batch_unlocked(gr_server_state_t *state,
+		replica_t *source_replica)
+{
+	ring_buffer_t *queue = &state->replica_batch_queues[*source_replica];
+	batch_header_t *batch = ring_buffer_peek(queue);
+	for (unsigned int i = 0; i < batch->num_updates; ++i) {
+		ring_buffer_shift(&state->replica_update_queues[*source_replica]);
+	}
+	ring_buffer_shift(queue);
+	if (!ring_buffer_is_empty(queue)) {
+		gr_process_replica_update_batch_work(state, *source_replica);
+	} else {
+		cpu_allow_no_time(state->cpu);
+	}
+}
+
+void gr_flush_replication_batch(gr_server_state_t *state, gr_tsp time)
+{
+	unsigned int num_updates = state->replication_batch_count;
+	gr_replica_update_batch_t *batch = gr_replica_update_batch_pooled(
+			state->server_state.messages, num_updates);
+	batch->source_replica = state->config->replica;
+	memcpy(gr_replica_update_batch_updates(batch), state->replication_batch,
+			num_updates * sizeof(gr_replica_update_entry_t));
+	for (unsigned int i = 0; i < num_updates; ++i) {
+		set_max(&time, state->replication_batch[i].update_time);
+	}
+	batch->time = time;
+	set_max(&state->replicated_time, time);
+	cpu_add_time(state->cpu, build_struct_per_byte_time()
+			* (simtime_t) batch->simulated_size);
+
+	server_multicast(&state->server_state, state->config->replica_peers,
+			state->config->num_replica_peers, GR_REPLICA_UPDATE_BATCH,
+			&batch->message);
+
+	state->replication_batch_count = 0;
+	++state->replication_batch_id;
+}
+
+void gr_process_replication_batch_timeout(gr_server_state_t *state,
+		unsigned int *batch_id)
+{
+	// The batch may already have been flushed because it was full or by a
+	// heartbeat
+	if (*batch_id == state->replication_batch_id
+			&& state->replication_batch_count > 0) {
+		gr_flush_replication_batch(state, 0);
+	} else {
+		cpu_allow_no_time(state->cpu);
+	}
+}
+
+// Buffer an update until the batch is full or its interval elapses
+static void gr_batch_value(gr_server_state_t *state,
+		gr_replica_update_entry_t *update)
+{
+	state->replication_batch[state->replication_batch_count++] = *update;
+	if (state->replication_batch_count == replication_batch_size()) {
+		gr_flush_replication_batch(state, 0);
+	} else if (state->replication_batch_count == 1
+			&& replication_batch_interval() > 0) {
+		server_schedule_self(&state->server_state,
+				replication_batch_interval(), GR_REPLICATION_BATCH_TIMEOUT,
+				&state->replication_batch_id, sizeof(unsigned int));
+	}
+}
+
 void gr_replicate_value(gr_server_state_t *state, gr_key key, gr_value value,
 		gr_tsp update_time, gr_tsp previous_update_time,
 		replica_t previous_source_replica, gr_tsp update_time_no_skew)
 {
-	gr_replica_update_t *update = gr_replica_update_new();
+	if (replication_batch_size() > 0) {
+		gr_replica_update_entry_t update = {
+			.key = key,
+			.value = value,
+			.update_time = update_time,
+			.update_time_no_skew = update_time_no_skew,
+			.previous_update_time = previous_update_time,
+			.previous_source_replica = previous_source_replica,
+		};
+		gr_batch_value(state, &update);
+		return;
+	}
+
+	gr_replica_update_t *update = gr_replica_update_pooled(
+			state->server_state.messages);
 	update->key = key;
 	update->value = value;
 	update->update_time = update_time;
@@ -102,17 +496,11 @@ void gr_replicate_value(gr_server_state_t *state, gr_key key, gr_value value,
 	update->source_replica = state->config->replica;
 	update->previous_update_time = previous_update_time;
 	update->previous_source_replica = previous_source_replica;
+	set_max(&state->replicated_time, update_time);
 	cpu_add_time(state->cpu, build_struct_per_byte_time()
 			* (simtime_t) update->simulated_size);
 
-	void send_update(lpid_t replica_lpid, replica_t replica) {
-		if (replica == state->config->replica) return;
-		server_send(&state->server_state, replica_lpid, GR_REPLICA_UPDATE,
-				&update->message);
-	}
-
-	foreach_replica(state->config->cluster, state->config->partition,
-			send_update);
-
-	free(update);
+	server_multicast(&state->server_state, state->config->replica_peers,
+			state->config->num_replica_peers, GR_REPLICA_UPDATE,
+			&update->message);
 }
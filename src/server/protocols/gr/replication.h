@@ -9,13 +9,45 @@
 #include "messages/gr.h"
 #include "server/protocols/gr/gr.h"
 
+void gr_replication_init(gr_server_state_t *state);
 void gr_replicate_value(gr_server_state_t *state, gr_key key, gr_value value,
 		gr_tsp update_time, gr_tsp previous_update_time,
 		replica_t previous_source_replica, gr_tsp update_time_no_skew_);
 void gr_process_replica_update(gr_server_state_t *state, gr_replica_update_t *update);
 void gr_process_replica_update_locked(gr_server_state_t *state,
-		gr_replica_update_t *update);
+		replica_t *source_replica);
 void gr_process_replica_update_unlocked(gr_server_state_t *state,
-		gr_replica_update_t *update);
+		replica_t *source_replica);
+
+/* Parallel apply, used when `parallel_replica_update_locks` is set. Updates
+ * to different keys are applied concurrently, each under the lock its key is
+ * assigned to. */
+typedef struct {
+	replica_t source_replica;
+	unsigned int sequence_number; // Position in the stream of the source
+	gr_key key;
+} gr_replica_update_ref_t;
+
+void gr_process_replica_update_parallel_locked(gr_server_state_t *state,
+		gr_replica_update_ref_t *ref);
+void gr_process_replica_update_parallel_unlocked(gr_server_state_t *state,
+		gr_replica_update_ref_t *ref);
+
+/* Batched replication, used when `replication_batch_size` is set. Updates
+ * are buffered and sent together to every other replica when the batch is
+ * full, when `replication_batch_interval` elapses or with the next heartbeat.
+ */
+void gr_process_replica_update_batch(gr_server_state_t *state,
+		gr_replica_update_batch_t *batch);
+void gr_process_replica_update_batch_locked(gr_server_state_t *state,
+		replica_t *source_replica);
+void gr_process_replica_update_batch_unlocked(gr_server_state_t *state,
+		replica_t *source_replica);
+void gr_process_replication_batch_timeout(gr_server_state_t *state,
+		unsigned int *batch_id);
+
+/* Send the buffered updates, even if there are none. No update with a time
+ * lower than the given one will be replicated afterwards. */
+void gr_flush_replication_batch(gr_server_state_t *state, gr_tsp time);
 
 #endif
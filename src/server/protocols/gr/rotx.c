@@ -7,9 +7,45 @@
 #include "server/protocols/gr/snapshot.h"
 #include <assert.h>
 #include <limits.h>
+#include <math.h>
 
 static DEFINE_PROTOCOL_TIMING_FUNC(update_gst_per_rotx_time, "gr");
 
+/* How the simulated server finds the ROTXs to release when the GST is
+ * updated. With "scan" all the ROTX states are visited and the ready ones
+ * released as they are found, "scan_upfront" charges the whole scan before
+ * releasing any of them, with "heap" the waiting ROTXs are kept in a heap
+ * ordered by dependency time. */
+enum rotx_wait_cost_model {
+	ROTX_WAIT_SCAN,
+	ROTX_WAIT_SCAN_UPFRONT,
+	ROTX_WAIT_HEAP,
+};
+
+static enum rotx_wait_cost_model rotx_wait_cost_model(void)
+{
+	static enum rotx_wait_cost_model value;
+	static int valid;
+	if (!valid) {
+		struct json_object *obj = param_get_object_root("protocol");
+		obj = param_get_object(obj, "gr");
+		const char *name = param_get_string_default(obj,
+				"rotx_wait_cost_model", "scan");
+		if (!strcmp(name, "scan")) {
+			value = ROTX_WAIT_SCAN;
+		} else if (!strcmp(name, "scan_upfront")) {
+			value = ROTX_WAIT_SCAN_UPFRONT;
+		} else if (!strcmp(name, "heap")) {
+			value = ROTX_WAIT_HEAP;
+		} else {
+			fprintf(stderr, "ROTX wait cost model \"%s\" is unknown.\n", name);
+			exit(1);
+		}
+		valid = 1;
+	}
+	return value;
+}
+
 struct gr_rotx_state_message {
 	unsigned int id;
 };
@@ -53,6 +89,7 @@ void gr_process_rotx_request(gr_server_state_t *state, gr_get_rotx_request_t *re
 
 	rotx->client_lpid = request->client_lpid;
 	rotx->dependency_time = request->dependency_time;
+	rotx->ready = 0;
 	rotx->snapshot_request = gr_get_snapshot_request_new(request->num_keys);
 	rotx->snapshot_request->client_lpid = state->config->lpid;
 	rotx->snapshot_request->gst = request->gst;
@@ -64,10 +101,10 @@ void gr_process_rotx_request(gr_server_state_t *state, gr_get_rotx_request_t *re
 			* (simtime_t) rotx->snapshot_request->simulated_size);
 
 	if (request->dependency_time <= state->gst) {
-		rotx->waiting_gst = 0;
 		gr_send_rotx_snapshot_request(state, msg.id);
 	} else {
-		rotx->waiting_gst = 1;
+		min_heap_push(&state->rotxs_waiting_gst, rotx->dependency_time,
+				msg.id);
 	}
 }
 
@@ -77,7 +114,8 @@ void gr_process_rotx_snapshot_response(gr_server_state_t *state,
 	unsigned int rotx_id = snapshot->request_id;
 	gr_rotx_state_t *rotx = gr_rotx_state_get(state, rotx_id);
 	gr_get_rotx_response_t *response =
-		gr_get_rotx_response_new(snapshot->num_values);
+		gr_get_rotx_response_pooled(state->server_state.messages,
+				snapshot->num_values);
 	memcpy(gr_get_rotx_response_values(response),
 			gr_get_snapshot_response_values(snapshot),
 			snapshot->num_values * sizeof(gr_value));
@@ -89,21 +127,72 @@ void gr_process_rotx_snapshot_response(gr_server_state_t *state,
 			&response->message);
 	server_stats_counter_inc(&state->server_state, ROTX_REQUESTS);
 	gr_rotx_state_free(state, rotx_id);
-	free(response);
 }
 
-static void rotx_gst_update_callback(unsigned int id, void *rotx_, void *data)
+static void rotx_scan_callback(unsigned int id, void *rotx_, void *data)
 {
 	gr_server_state_t *state = (gr_server_state_t*) data;
 	gr_rotx_state_t *rotx = (gr_rotx_state_t*) rotx_;
 	cpu_add_time(state->cpu, update_gst_per_rotx_time());
-	if (rotx->waiting_gst && rotx->dependency_time < state->gst) {
-		rotx->waiting_gst = 0;
+	if (rotx->ready) {
+		rotx->ready = 0;
 		gr_send_rotx_snapshot_request(state, id);
 	}
 }
 
+/* Charge a scan of all the ROTX states and send the snapshot requests of
+ * the ready ones in the order the scan finds them. */
+static void rotx_scan(gr_server_state_t *state)
+{
+	min_heap_t *waiting = &state->rotxs_waiting_gst;
+	int any_ready = 0;
+	min_heap_entry_t *top;
+	while ((top = min_heap_peek(waiting)) != NULL
+			&& top->key < state->gst) {
+		gr_rotx_state_get(state, top->value)->ready = 1;
+		any_ready = 1;
+		min_heap_pop(waiting);
+	}
+
+	if (any_ready) {
+		ptr_array_foreach(&state->rotx_states, rotx_scan_callback, state);
+	} else {
+		unsigned int num_rotxs = ptr_array_count(&state->rotx_states);
+		for (unsigned int i = 0; i < num_rotxs; ++i) {
+			cpu_add_time(state->cpu, update_gst_per_rotx_time());
+		}
+	}
+}
+
 void gr_rotx_on_gst_updated(gr_server_state_t *state)
 {
-	ptr_array_foreach(&state->rotx_states, rotx_gst_update_callback, state);
+	min_heap_t *waiting = &state->rotxs_waiting_gst;
+	switch (rotx_wait_cost_model()) {
+		case ROTX_WAIT_SCAN:
+			rotx_scan(state);
+			return;
+		case ROTX_WAIT_SCAN_UPFRONT: {
+			unsigned int num_rotxs = ptr_array_count(&state->rotx_states);
+			for (unsigned int i = 0; i < num_rotxs; ++i) {
+				cpu_add_time(state->cpu, update_gst_per_rotx_time());
+			}
+			break;
+		}
+		case ROTX_WAIT_HEAP:
+			// Look at the top of the heap, then sift down for each release
+			cpu_add_time(state->cpu, update_gst_per_rotx_time());
+			break;
+	}
+
+	min_heap_entry_t *top;
+	while ((top = min_heap_peek(waiting)) != NULL
+			&& top->key < state->gst) {
+		unsigned int id = top->value;
+		if (rotx_wait_cost_model() == ROTX_WAIT_HEAP) {
+			cpu_add_time(state->cpu, update_gst_per_rotx_time()
+					* (1 + log2(min_heap_size(waiting))));
+		}
+		min_heap_pop(waiting);
+		gr_send_rotx_snapshot_request(state, id);
+	}
 }
@@ -9,6 +9,7 @@
 #include <assert.h>
 
 static DEFINE_PROTOCOL_TIMING_FUNC(process_slice_response_per_value_time, "gr");
+static DEFINE_PROTOCOL_TIMING_FUNC(local_slice_read_per_value_time, "gr");
 
 static int is_value_visible_snapshot(gr_server_state_t *state, item_t *item,
 		gr_tsp time)
@@ -21,7 +22,7 @@ void gr_process_slice_request(gr_server_state_t *state, gr_slice_request_t *requ
 {
 	if (gr_gst_need_update(state, request->snapshot_time)) {
 		cpu_lock_lock(state->cpu, state->lock, GR_SLICE_REQUEST_LOCKED,
-				request, request->simulated_size);
+				request, request->size);
 	} else {
 		gr_process_slice_request_unlocked(state, request);
 	}
@@ -32,24 +33,56 @@ void gr_process_slice_request_locked(gr_server_state_t *state,
 {
 	gr_update_gst(state, request->snapshot_time);
 	cpu_lock_unlock(state->cpu, state->lock, GR_SLICE_REQUEST_UNLOCKED,
-			request, request->simulated_size);
+			request, request->size);
 }
 
 void gr_process_slice_request_unlocked(gr_server_state_t *state,
 		gr_slice_request_t *request)
 {
-	gr_slice_response_t *response = gr_slice_response_new();
-	gr_get_value_at(&response->value, &response->update_time, NULL, state,
-			request->key, request->snapshot_time, is_value_visible_snapshot);
+	// Versions older than gc_time may have been collected, see store.c
+	assert(request->snapshot_time >= state->gc_time);
+	gr_slice_response_t *response = gr_slice_response_pooled(
+			state->server_state.messages, request->num_keys);
+	gr_key *keys = gr_slice_request_keys(request);
+	gr_tsp *update_times = gr_slice_response_update_times(response);
+	gr_value *values = gr_slice_response_values(response);
+	for (unsigned int i = 0; i < request->num_keys; ++i) {
+		gr_get_value_at(&values[i], &update_times[i], NULL, state, keys[i],
+				request->snapshot_time, is_value_visible_snapshot);
+	}
+	memcpy(gr_slice_response_key_ids(response), gr_slice_request_key_ids(request),
+			request->num_keys * sizeof(unsigned int));
 	response->gst = state->gst;
 	response->snapshot_id = request->snapshot_id;
-	response->key_id = request->key_id;
 	cpu_add_time(state->cpu, build_struct_per_byte_time()
 			* (simtime_t) response->simulated_size);
 	server_send(&state->server_state, request->from_lpid,
 			GR_SLICE_RESPONSE, &response->message);
 }
 
+void gr_read_local_slice(gr_server_state_t *state, unsigned int snapshot_id)
+{
+	gr_snapshot_state_t *snapshot = gr_snapshot_state_get(state, snapshot_id);
+	unsigned int num_values = 0;
+	for (unsigned int k = 0; k < snapshot->size; ++k) {
+		if (gr_lpid_for_key(snapshot->keys[k], state) != state->config->lpid) {
+			continue;
+		}
+		gr_tsp update_time;
+		gr_get_value_at(&snapshot->values[k], &update_time, NULL, state,
+				snapshot->keys[k], snapshot->time, is_value_visible_snapshot);
+		set_max(&snapshot->update_time, update_time);
+		++num_values;
+	}
+	if (num_values == 0) return;
+	set_max(&snapshot->gst, state->gst);
+	snapshot->received_values += num_values;
+	cpu_add_time(state->cpu, num_values * local_slice_read_per_value_time());
+	if (snapshot->received_values == snapshot->size) {
+		gr_send_snapshot_response(state, snapshot_id);
+	}
+}
+
 void gr_process_slice_response(gr_server_state_t *state,
 		gr_slice_response_t *slice)
 {
@@ -74,11 +107,17 @@ void gr_process_slice_response_unlocked(gr_server_state_t *state,
 {
 	gr_snapshot_state_t *snapshot =
 		gr_snapshot_state_get(state, slice->snapshot_id);
-	snapshot->values[slice->key_id] = slice->value;
-	set_max(&snapshot->update_time, slice->update_time);
+	unsigned int *key_ids = gr_slice_response_key_ids(slice);
+	gr_tsp *update_times = gr_slice_response_update_times(slice);
+	gr_value *values = gr_slice_response_values(slice);
+	for (unsigned int i = 0; i < slice->num_values; ++i) {
+		snapshot->values[key_ids[i]] = values[i];
+		set_max(&snapshot->update_time, update_times[i]);
+	}
 	set_max(&snapshot->gst, slice->gst);
-	++snapshot->received_values;
-	cpu_add_time(state->cpu, process_slice_response_per_value_time());
+	snapshot->received_values += slice->num_values;
+	cpu_add_time(state->cpu,
+			slice->num_values * process_slice_response_per_value_time());
 	if (snapshot->received_values == snapshot->size) {
 			gr_send_snapshot_response(state, slice->snapshot_id);
 	}
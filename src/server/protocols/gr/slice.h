@@ -20,4 +20,8 @@ void gr_process_slice_request_locked(gr_server_state_t *state,
 void gr_process_slice_request_unlocked(gr_server_state_t *state,
 		gr_slice_request_t *request);
 
+/* Read the keys of the snapshot owned by this server directly instead of
+ * sending a slice request to itself. */
+void gr_read_local_slice(gr_server_state_t *state, unsigned int snapshot_id);
+
 #endif
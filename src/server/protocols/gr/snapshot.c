@@ -1,13 +1,17 @@
 #include "server/protocols/gr/snapshot.h"
+#include "cluster.h"
 #include "common.h"
 #include "event.h"
 #include "parameters.h"
 #include "server/protocols/gr/gst.h"
 #include "server/protocols/gr/rotx.h"
+#include "server/protocols/gr/slice.h"
 #include "server/protocols/gr/store.h"
 #include <assert.h>
 #include <limits.h>
 
+static DEFINE_PROTOCOL_PARAMETER_DEFAULT_FUNC(local_slice_reads, uint, "gr", 0);
+
 struct gr_snapshot_state_message{
 	unsigned int id;
 };
@@ -83,21 +87,73 @@ void gr_process_get_snapshot_request_locked(gr_server_state_t *state,
 			msg, gr_snapshot_state_message_size(msg));
 }
 
-void gr_process_get_snapshot_request_unlocked(gr_server_state_t *state,
-		gr_snapshot_state_message_t *msg)
+static void send_slice_request(gr_server_state_t *state,
+		unsigned int snapshot_id, lpid_t partition_lpid,
+		unsigned int *key_indices, unsigned int num_keys)
 {
-	gr_snapshot_state_t *snapshot = gr_snapshot_state_get(state, msg->id);
-	gr_slice_request_t *slice = gr_slice_request_new();
+	gr_snapshot_state_t *snapshot = gr_snapshot_state_get(state, snapshot_id);
+	gr_slice_request_t *slice = gr_slice_request_pooled(
+			state->server_state.messages, num_keys);
 	slice->from_lpid = state->config->lpid;
 	slice->snapshot_time = snapshot->time;
-	slice->snapshot_id = msg->id;
+	slice->snapshot_id = snapshot_id;
+	gr_key *slice_keys = gr_slice_request_keys(slice);
+	unsigned int *slice_key_ids = gr_slice_request_key_ids(slice);
+	for (unsigned int i = 0; i < num_keys; ++i) {
+		slice_key_ids[i] = key_indices[i];
+		slice_keys[i] = snapshot->keys[key_indices[i]];
+	}
 	cpu_add_time(state->cpu, build_struct_per_byte_time()
 			* (simtime_t) slice->simulated_size);
-	for (unsigned int i = 0; i < snapshot->size; ++i) {
-		slice->key_id = i;
-		slice->key = snapshot->keys[i];
-		server_send(&state->server_state, gr_lpid_for_key(slice->key, state),
-				GR_SLICE_REQUEST, &slice->message);
+	server_send(&state->server_state, partition_lpid, GR_SLICE_REQUEST,
+			&slice->message);
+}
+
+void gr_process_get_snapshot_request_unlocked(gr_server_state_t *state,
+		gr_snapshot_state_message_t *msg)
+{
+	gr_snapshot_state_t *snapshot = gr_snapshot_state_get(state, msg->id);
+	cluster_config_t *cluster = state->config->cluster;
+	partition_t self = state->config->partition;
+	int read_locally = local_slice_reads() != 0;
+
+	// Bucket the key indices by partition, in the order of the keys
+	if (state->slice_key_order_size < snapshot->size) {
+		state->slice_key_order_size = snapshot->size;
+		state->slice_key_order = realloc(state->slice_key_order,
+				snapshot->size * sizeof(unsigned int));
+	}
+	unsigned int *order = state->slice_key_order;
+	unsigned int *ends = state->slice_key_ends;
+	memset(ends, 0, cluster->num_partitions * sizeof(unsigned int));
+	for (unsigned int k = 0; k < snapshot->size; ++k) {
+		++ends[partition_for_key(cluster, snapshot->keys[k])];
+	}
+	unsigned int start = 0;
+	for (partition_t p = 0; p < cluster->num_partitions; ++p) {
+		unsigned int num_keys = ends[p];
+		ends[p] = start;
+		start += num_keys;
+	}
+	for (unsigned int k = 0; k < snapshot->size; ++k) {
+		order[ends[partition_for_key(cluster, snapshot->keys[k])]++] = k;
+	}
+
+	// Send a single slice request to each partition owning some of the keys,
+	// ends[p] is now the start of the keys of partition p + 1
+	start = 0;
+	for (partition_t p = 0; p < cluster->num_partitions; ++p) {
+		unsigned int num_keys = ends[p] - start;
+		if (num_keys > 0 && !(read_locally && p == self)) {
+			lpid_t partition_lpid = p == self ? state->config->lpid
+				: state->config->partition_peers[p < self ? p : p - 1];
+			send_slice_request(state, msg->id, partition_lpid, order + start,
+					num_keys);
+		}
+		start = ends[p];
+	}
+	if (read_locally) {
+		gr_read_local_slice(state, msg->id);
 	}
 }
 
@@ -105,7 +161,8 @@ void gr_send_snapshot_response(gr_server_state_t *state, unsigned int snapshot_i
 {
 	gr_snapshot_state_t *snapshot = gr_snapshot_state_get(state, snapshot_id);
 	gr_get_snapshot_response_t *response =
-		gr_get_snapshot_response_new(snapshot->size);
+		gr_get_snapshot_response_pooled(state->server_state.messages,
+				snapshot->size);
 	response->gst = snapshot->gst;
 	response->update_timestamp = snapshot->update_time;
 	response->request_id = snapshot->request_id;
@@ -119,6 +176,5 @@ void gr_send_snapshot_response(gr_server_state_t *state, unsigned int snapshot_i
 		server_send(&state->server_state, snapshot->client_lpid,
 				GR_GET_SNAPSHOT_RESPONSE, &response->message);
 	}
-	free(response);
 	gr_snapshot_state_free(state, snapshot_id);
 }
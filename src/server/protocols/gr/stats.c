@@ -4,34 +4,92 @@
 #include "server/protocols/gr/store.h"
 #include "server/stats.h"
 
+/* Values from remote replicas which are not visible yet. There is one ring
+ * per source replica, ordered by update time, so that a GST update only has
+ * to look at the values becoming visible instead of the whole store. */
+typedef struct {
+	gr_key key;
+	gr_tsp update_time;
+} pending_value_t;
+
+void gr_stats_init(gr_server_state_t *state)
+{
+	unsigned int num_replicas = state->config->cluster->num_replicas;
+	state->pending_visibility = malloc(num_replicas * sizeof(ring_buffer_t));
+	for (unsigned int i = 0; i < num_replicas; ++i) {
+		ring_buffer_init(&state->pending_visibility[i],
+				sizeof(pending_value_t));
+	}
+}
+
 void gr_stats_get_request(gr_server_state_t *state, gr_key key,
 		gr_tsp update_timestamp)
 {
 	if (state->now < app_params.ignore_initial_seconds) return;
 	server_stats_counter_inc(&state->server_state, GET_REQUESTS);
-	item_t *latest_item = store_get(state->store, key);
+	item_t *latest_item = gr_latest_version(state, key);
 	simtime_t latest_update = latest_item ? latest_item->update_time : 0;
 	server_stats_array_push(&state->server_state, VALUE_STALENESS,
 			latest_update - update_timestamp);
 }
 
+void gr_stats_value_stored(gr_server_state_t *state, gr_key key,
+		item_t *item)
+{
+	// Local values and values which are already visible are never counted
+	if (item->source_replica == state->config->replica
+			|| item->update_time <= state->gst) {
+		return;
+	}
+	ring_buffer_t *ring = &state->pending_visibility[item->source_replica];
+	pending_value_t pending = {key, item->update_time};
+	ring_buffer_push(ring, &pending);
+	// Updates from a given replica are almost always received in order
+	unsigned int i = ring_buffer_size(ring) - 1;
+	while (i > 0 && ((pending_value_t*) ring_buffer_get(ring, i - 1))
+			->update_time > pending.update_time) {
+		ring_buffer_swap(ring, i - 1, i);
+		--i;
+	}
+}
+
+/* Whether the given value was hidden at old_gst, that is whether it is still
+ * in the store and no newer version of the key was visible before it. */
+static int was_hidden(gr_server_state_t *state, gr_key key,
+		replica_t source_replica, gr_tsp update_time, gr_tsp old_gst)
+{
+	item_t *item = gr_latest_version(state, key);
+	while (item != NULL) {
+		if (item->source_replica == source_replica
+				&& item->update_time == update_time) {
+			return 1;
+		}
+		if (item->source_replica == state->config->replica
+				|| item->update_time <= old_gst) {
+			return 0;
+		}
+		item = item->previous_version;
+	}
+	return 0;
+}
+
 void gr_stats_gst_update(gr_server_state_t *state, gr_tsp old_gst,
 		gr_tsp new_gst)
 {
-	if (state->now < app_params.ignore_initial_seconds) return;
-	simtime_t saved_time = cpu_elapsed_time(state->cpu);
-	void process_item(gr_key key, void *_item) {
-		(void) key; // Unused parameter
-		item_t *item = (item_t*) _item;
-		while (item != NULL && !gr_is_value_visible(state, item, old_gst)) {
-			if (gr_is_value_visible(state, item, new_gst)) {
+	int ignored = state->now < app_params.ignore_initial_seconds;
+	unsigned int num_replicas = state->config->cluster->num_replicas;
+	for (replica_t r = 0; r < num_replicas; ++r) {
+		ring_buffer_t *ring = &state->pending_visibility[r];
+		pending_value_t *pending;
+		while ((pending = ring_buffer_peek(ring)) != NULL
+				&& pending->update_time <= new_gst) {
+			if (!ignored && was_hidden(state, pending->key, r,
+						pending->update_time, old_gst)) {
 				server_stats_array_push(&state->server_state,
 						VISIBILITY_LATENCY,
-						state->now - item->update_time);
+						state->now - pending->update_time);
 			}
-			item = item->previous_version;
+			ring_buffer_shift(ring);
 		}
 	}
-	store_foreach_item(state->store, process_item);
-	cpu_set_elapsed_time(state->cpu, saved_time);
 }
@@ -1,4 +1,5 @@
 #include "server/protocols/gr/store.h"
+#include "server/protocols/gr/stats.h"
 #include "cluster.h"
 #include "common.h"
 #include "parameters.h"
@@ -8,6 +9,121 @@
 static DEFINE_PROTOCOL_TIMING_FUNC(get_value_time, "gr");
 static DEFINE_PROTOCOL_TIMING_FUNC(put_value_time, "gr");
 static DEFINE_PROTOCOL_TIMING_FUNC(is_value_visible_time, "gr");
+static DEFINE_PROTOCOL_TIMING_FUNC(garbage_collect_per_version_time, "gr");
+static DEFINE_PROTOCOL_PARAMETER_DEFAULT_FUNC(gc_keys_per_round, uint, "gr", 0);
+
+#define ITEMS_PER_SLAB 64
+
+/* Versions are allocated by slabs and recycled through a free list linked by
+ * their previous_version pointer so that a garbage collected part of a version
+ * chain can be returned at once. */
+static item_t *item_new(gr_server_state_t *state)
+{
+	if (state->free_items == NULL) {
+		item_t *slab = malloc(ITEMS_PER_SLAB * sizeof(item_t));
+		for (unsigned int i = 0; i < ITEMS_PER_SLAB; ++i) {
+			slab[i].previous_version = state->free_items;
+			state->free_items = &slab[i];
+		}
+	}
+	item_t *item = state->free_items;
+	state->free_items = item->previous_version;
+	return item;
+}
+
+static void item_free_chain(gr_server_state_t *state, item_t *first)
+{
+	item_t *last = first;
+	while (last->previous_version != NULL) {
+		last = last->previous_version;
+	}
+	last->previous_version = state->free_items;
+	state->free_items = first;
+}
+
+/* With the "inline_versions" cluster parameter set to K > 0, the store maps
+ * each key to a block keeping its K latest versions in a ring so that walking
+ * through recent versions touches contiguous memory. Older versions spill to
+ * separately allocated items. Either way, versions are linked from the latest
+ * to the oldest through previous_version. */
+typedef struct version_block {
+	unsigned int latest; // Slot of the latest version
+	unsigned int count; // Number of versions in the ring
+	item_t slots[];
+} version_block_t;
+
+static unsigned int inline_versions(gr_server_state_t *state)
+{
+	return state->config->cluster->inline_versions;
+}
+
+static int is_inline(gr_server_state_t *state, version_block_t *block,
+		item_t *item)
+{
+	return item >= block->slots && item < block->slots + inline_versions(state);
+}
+
+item_t *gr_latest_version(gr_server_state_t *state, gr_key key)
+{
+	void *value = store_get(state->store, key);
+	if (value == NULL || inline_versions(state) == 0) return value;
+	version_block_t *block = value;
+	return &block->slots[block->latest];
+}
+
+/* Store a new version of the key whose other fields are left to the caller. */
+static item_t *new_version(gr_server_state_t *state, gr_key key,
+		item_t *previous_version)
+{
+	unsigned int k = inline_versions(state);
+	if (k == 0) {
+		item_t *item = item_new(state);
+		item->previous_version = previous_version;
+		store_put(state->store, key, item);
+		return item;
+	}
+	version_block_t *block = store_get(state->store, key);
+	if (block == NULL) {
+		block = malloc(sizeof(version_block_t) + k * sizeof(item_t));
+		block->latest = k - 1;
+		block->count = 0;
+		store_put(state->store, key, block);
+	}
+	if (block->count == k) {
+		// Spill the oldest inline version to make room for the new one
+		unsigned int oldest = (block->latest + 1) % k;
+		item_t *spilled = item_new(state);
+		*spilled = block->slots[oldest];
+		if (previous_version == &block->slots[oldest]) {
+			previous_version = spilled;
+		} else {
+			block->slots[(oldest + 1) % k].previous_version = spilled;
+		}
+		--block->count;
+	}
+	block->latest = (block->latest + 1) % k;
+	++block->count;
+	item_t *item = &block->slots[block->latest];
+	item->previous_version = previous_version;
+	return item;
+}
+
+/* Free all the versions of the key older than the given one. */
+static void truncate_versions(gr_server_state_t *state, gr_key key,
+		item_t *item)
+{
+	item_t *older = item->previous_version;
+	item->previous_version = NULL;
+	if (inline_versions(state) > 0) {
+		// Inline versions all come before the spilled ones
+		version_block_t *block = store_get(state->store, key);
+		while (older != NULL && is_inline(state, block, older)) {
+			--block->count;
+			older = older->previous_version;
+		}
+	}
+	if (older != NULL) item_free_chain(state, older);
+}
 
 lpid_t gr_lpid_for_key(gr_key key, gr_server_state_t *state) {
 	partition_t partition = partition_for_key(state->config->cluster, key);
@@ -15,27 +131,52 @@ lpid_t gr_lpid_for_key(gr_key key, gr_server_state_t *state) {
 			state->config->replica, partition);
 }
 
-void gr_garbage_collect(gr_server_state_t *state)
+/* Free the versions of the key that cannot be read anymore: the latest version
+ * and the previous one are always kept, older ones only down to the first
+ * version older than gc_time. Return whether more than two versions remain.
+ *
+ * Slice reads are done at the snapshot time of their coordinator, which may
+ * be lower than the GST of this partition. gc_time must thus stay at or below
+ * the GST of every partition of the replica when it built its pending slice
+ * requests. gst.c keeps it one GST behind: the GST replaced by the root in the
+ * tree topologies, and the minimum of the GSTs the partitions broadcast before
+ * their latest ones in the broadcast topology. This holds as long as a slice
+ * request is delivered within a GST round. */
+static int garbage_collect_key(gr_server_state_t *state, gr_key key,
+		item_t *latest)
 {
-	void garbage_collect_item(gr_key key, void *value) {
-		(void) key; // Unused parameter
-		item_t *item = (item_t*) value;
-		item = item->previous_version; // Always keep the latest version and the previous one.
-		while (item != NULL) {
-			if (item->update_time < state->gst) {
-				item_t *next = item->previous_version;
-				item->previous_version = NULL;
-				while (next != NULL) {
-					item = next;
-					next = item->previous_version;
-					free(item);
-				}
-				break;
+	unsigned int num_visited = 0;
+	item_t *item = latest->previous_version;
+	while (item != NULL) {
+		++num_visited;
+		if (item->update_time < state->gc_time) {
+			if (item->previous_version != NULL) {
+				truncate_versions(state, key, item);
 			}
-			item = item->previous_version;
+			break;
+		}
+		item = item->previous_version;
+	}
+	cpu_add_time(state->cpu, num_visited * garbage_collect_per_version_time());
+	return latest->previous_version != NULL
+		&& latest->previous_version->previous_version != NULL;
+}
+
+void gr_garbage_collect(gr_server_state_t *state)
+{
+	unsigned int num_keys = ring_buffer_size(&state->gc_keys);
+	if (num_keys > gc_keys_per_round()) num_keys = gc_keys_per_round();
+	for (unsigned int i = 0; i < num_keys; ++i) {
+		gr_key key = *(gr_key*) ring_buffer_peek(&state->gc_keys);
+		ring_buffer_shift(&state->gc_keys);
+		item_t *latest = gr_latest_version(state, key);
+		if (garbage_collect_key(state, key, latest)) {
+			// Versions too recent to be collected yet, retry in a later round
+			ring_buffer_push(&state->gc_keys, &key);
+		} else {
+			latest->gc_pending = 0;
 		}
 	}
-	store_foreach_item(state->store, garbage_collect_item);
 }
 
 int gr_is_value_visible(gr_server_state_t *state, item_t *item, gr_tsp gst)
@@ -60,7 +201,7 @@ void gr_get_value_at(gr_value *value_ptr, gr_tsp *update_time_ptr,
 		)
 {
 	assert(gr_lpid_for_key(key, state) == state->config->lpid);
-	item_t *item = store_get(state->store, key);
+	item_t *item = gr_latest_version(state, key);
 	assert(item == NULL || item->source_replica < state->config->cluster->num_replicas);
 	while (item != NULL && !is_visible(state, item, time)) {
 		assert(item->source_replica < state->config->cluster->num_replicas);
@@ -94,20 +235,28 @@ item_t *gr_put_value(gr_server_state_t *state, gr_key key, gr_value value,
 	assert(gr_lpid_for_key(key, state) == state->config->lpid);
 	cpu_add_time(state->cpu, put_value_time());
 
-	item_t *previous_version = store_get(state->store, key);
-	item_t *item = malloc(sizeof(item_t));
-	item->value = value;
-	item->update_time = update_time;
-	item->source_replica = source_replica;
-	item->previous_version = previous_version;
+	item_t *previous_version = gr_latest_version(state, key);
 
 	// Due to clock skew it is possible for the new value to be older in which
 	// case there is a conflict and the old value is ignored
 	if (previous_version != NULL
-			&& previous_version->update_time > item->update_time) {
-		free(item);
+			&& previous_version->update_time > update_time) {
 		return NULL;
 	}
-	store_put(state->store, key, item);
+
+	item_t *item = new_version(state, key, previous_version);
+	previous_version = item->previous_version; // May have been spilled
+	item->value = value;
+	item->update_time = update_time;
+	item->source_replica = source_replica;
+	item->gc_pending = previous_version != NULL && previous_version->gc_pending;
+	// Only keys with more than two versions have something to collect
+	if (!item->gc_pending && gc_keys_per_round() > 0
+			&& previous_version != NULL
+			&& previous_version->previous_version != NULL) {
+		item->gc_pending = 1;
+		ring_buffer_push(&state->gc_keys, &key);
+	}
+	gr_stats_value_stored(state, key, item);
 	return item;
 }
@@ -8,10 +8,19 @@ typedef struct item {
 	gr_value value;
 	gr_tsp update_time;
 	replica_t source_replica;
+	// Only meaningful for the latest version, whether the key is queued for
+	// garbage collection.
+	unsigned int gc_pending;
 	struct item *previous_version;
 } item_t;
 
 lpid_t gr_lpid_for_key(gr_key key, gr_server_state_t *state);
+
+/* Return the latest version of the key or NULL if there is none. */
+item_t *gr_latest_version(gr_server_state_t *state, gr_key key);
+
+/* Collect the old versions of a bounded number of keys, to be called after the
+ * GST has been updated. */
 void gr_garbage_collect(gr_server_state_t *state);
 int gr_is_value_visible(gr_server_state_t *state, item_t *item, gr_tsp gst);
 
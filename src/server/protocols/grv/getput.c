@@ -105,7 +105,8 @@ void grv_process_get_request_locked(grv_server_state_t *state,
 void grv_process_get_request_unlocked(grv_server_state_t *state,
 		grv_get_request_t *request)
 {
-	grv_get_response_t *response = grv_get_response_new(
+	grv_get_response_t *response = grv_get_response_pooled(
+			state->server_state.messages,
 			state->config->cluster->num_replicas);
 	grv_get_value(&response->value, &response->update_timestamp,
 			&response->source_replica, state, request->key);
@@ -119,7 +120,6 @@ void grv_process_get_request_unlocked(grv_server_state_t *state,
 			* (simtime_t) response->simulated_size);
 	server_send(&state->server_state, destination, GRV_GET_RESPONSE,
 			&response->message);
-	free(response);
 }
 
 /* Process a put request from a client or another server. */
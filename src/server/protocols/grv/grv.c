@@ -3,7 +3,6 @@
 #include "event.h"
 #include "messages/grv.h"
 #include "parameters.h"
-#include "queue.h"
 #include "server/protocols/grv/getput.h"
 #include "server/protocols/grv/gst.h"
 #include "server/protocols/grv/heartbeat.h"
@@ -38,12 +37,17 @@ static void grv_init_state(server_state_t *state_)
 	ptr_array_init(&state->put_states);
 	ptr_array_init(&state->rotx_states);
 
-	state->replica_update_queues = malloc(num_replicas * sizeof(queue_t*));
-	for (unsigned int i = 0; i < num_replicas; ++i) {
-		state->replica_update_queues[i] = queue_new();
-	}
+	grv_replication_init(state);
+	state->free_items = NULL;
+	ring_buffer_init(&state->gc_keys, sizeof(gr_key));
 
-	if (server_is_leaf_partition(&state->server_state)) {
+	state->partition_lst_vectors = NULL;
+	if (state->config->gst_topology == GST_TOPOLOGY_BROADCAST) {
+		state->partition_lst_vectors = calloc(
+				state->config->cluster->num_partitions * num_replicas,
+				sizeof(gr_tsp));
+		grv_schedule_gst_computation_start(state);
+	} else if (server_is_leaf_partition(&state->server_state)) {
 		grv_schedule_gst_computation_start(state);
 	}
 
@@ -127,6 +131,18 @@ static int grv_process_event(server_state_t *state_, unsigned int event_type,
 		case GRV_REPLICA_UPDATE_VV_UNLOCKED:
 			grv_process_replica_update_vv_unlocked(state, data);
 			break;
+		case GRV_REPLICA_UPDATE_BATCH:
+			grv_process_replica_update_batch(state, data);
+			break;
+		case GRV_REPLICA_UPDATE_BATCH_VV_LOCKED:
+			grv_process_replica_update_batch_vv_locked(state, data);
+			break;
+		case GRV_REPLICA_UPDATE_BATCH_VV_UNLOCKED:
+			grv_process_replica_update_batch_vv_unlocked(state, data);
+			break;
+		case GRV_REPLICATION_BATCH_TIMEOUT:
+			grv_process_replication_batch_timeout(state, data);
+			break;
 		case GRV_LST_FROM_LEAF:
 			grv_process_lst_from_leaf(state, data);
 			break;
@@ -148,6 +164,12 @@ static int grv_process_event(server_state_t *state_, unsigned int event_type,
 		case GRV_START_GST_COMPUTATION:
 			grv_process_start_gst_computation(state);
 			break;
+		case GRV_LST_BROADCAST:
+			grv_process_lst_broadcast(state, data);
+			break;
+		case GRV_LST_BROADCAST_LOCKED:
+			grv_process_lst_broadcast_locked(state);
+			break;
 		case GRV_CLOCK_TICK:
 			grv_process_clock_tick(state);
 			break;
@@ -4,7 +4,7 @@
 #include "cpu/lock.h"
 #include "protocols.h"
 #include "ptr_array.h"
-#include "queue.h"
+#include "ring_buffer.h"
 #include "server/server.h"
 
 typedef struct {
@@ -26,6 +26,7 @@ typedef struct {
 	gr_tsp *version_vector; // Physical timestamps from each replicas
 	gr_tsp *gst_vector;
 	gr_tsp *min_lst_vector;
+	gr_tsp *partition_lst_vectors; // Broadcast GST topology only, see gst.c
 	int *lst_received;
 	unsigned int num_snapshot_states;
 	grv_snapshot_state_t **snapshot_states;
@@ -35,7 +36,15 @@ typedef struct {
 	cpu_lock_id_t lock_gsv;
 	ptr_array_t put_states;
 	ptr_array_t rotx_states;
-	queue_t **replica_update_queues;
+	ring_buffer_t *replica_update_queues; // Per source replica, by value
+	ring_buffer_t *replica_dependency_queues; // Same, dependency vectors
+	ring_buffer_t *replica_batch_queues; // Per source replica, see replication.c
+	char *replication_batch; // Update entries, see replication.c
+	unsigned int replication_batch_count;
+	unsigned int replication_batch_id; // Incremented by each flush
+	gr_tsp replicated_time; // Latest time sent to the other replicas
+	struct item *free_items; // Recycled versions, see store.c
+	ring_buffer_t gc_keys; // Keys with old versions, see store.c
 } grv_server_state_t;
 
 #ifdef server_protocols_grv_grv_c
@@ -73,42 +73,22 @@ void grv_process_lst_from_leaf_root_locked(grv_server_state_t *state)
 			GRV_LST_FROM_LEAF_ROOT_UNLOCKED, NULL, 0);
 }
 
-struct grv_send_gst_data {
-	grv_server_state_t *state;
-	grv_gst_from_root_t *root_gst;
-};
-
-static void grv_send_gst(partition_t partition, void *data_)
-	{
-		struct grv_send_gst_data * data = (struct grv_send_gst_data *) data_;
-		grv_server_state_t *state = data->state;
-		lpid_t child_lpid = cluster_get_lpid(state->config->cluster,
-				state->config->replica, partition);
-		server_send(&state->server_state, child_lpid, GRV_GST_FROM_ROOT,
-				&data->root_gst->message);
-	}
-
 static void grv_send_gst_to_children(grv_server_state_t *state)
 {
 	unsigned int num_replicas = state->config->cluster->num_replicas;
-	grv_gst_from_root_t *root_gst = grv_gst_from_root_new(num_replicas);
+	grv_gst_from_root_t *root_gst = grv_gst_from_root_pooled(
+			state->server_state.messages, num_replicas);
 	grv_copy_gst_vector(grv_gst_from_root_gst_vector(root_gst), state);
 	cpu_add_time(state->cpu, build_struct_per_byte_time()
 			* (simtime_t) root_gst->size);
 
-	struct grv_send_gst_data data = {
-		.state = state,
-		.root_gst = root_gst,
-	};
-	server_foreach_children_partition(&state->server_state, grv_send_gst, &data);
-	free(root_gst);
+	server_multicast(&state->server_state, state->config->children_lpids,
+			state->config->num_children, GRV_GST_FROM_ROOT,
+			&root_gst->message);
 }
 
 void grv_process_lst_from_leaf_root_unlocked(grv_server_state_t *state)
 {
-	// FIXME Currently garbage collection doesn't take cpu time
-	// FIXME Garbage collection is currently disabled as it takes too much real time
-	//garbage_collect(state);
 	grv_send_gst_to_children(state);
 }
 
@@ -116,21 +96,18 @@ void grv_send_lst_to_parent(grv_server_state_t *state)
 {
 	assert(state->config->partition != 0);
 	unsigned int num_replicas = state->config->cluster->num_replicas;
-	grv_lst_from_leaf_t *leaf_lst = grv_lst_from_leaf_new(num_replicas);
+	grv_lst_from_leaf_t *leaf_lst = grv_lst_from_leaf_pooled(
+			state->server_state.messages, num_replicas);
 	memcpy(grv_lst_from_leaf_lst_vector(leaf_lst), state->min_lst_vector,
 			num_replicas * sizeof(*state->min_lst_vector));
 	leaf_lst->leaf_partition_id = state->config->partition;
 	for (unsigned int i = 0; i < state->config->tree_fanout; ++i) {
 		state->lst_received[i] = 0;
 	}
-	unsigned int parent_partition = server_parent_partition_id(&state->server_state);
-	lpid_t parent_lpid = cluster_get_lpid(state->config->cluster,
-			state->config->replica, parent_partition);
 	cpu_add_time(state->cpu, build_struct_per_byte_time()
 			* (simtime_t) leaf_lst->simulated_size);
-	server_send(&state->server_state, parent_lpid, GRV_LST_FROM_LEAF,
-			&leaf_lst->message);
-	free(leaf_lst);
+	server_send(&state->server_state, state->config->parent_lpid,
+			GRV_LST_FROM_LEAF, &leaf_lst->message);
 }
 
 void grv_schedule_gst_computation_start(grv_server_state_t *state)
@@ -142,12 +119,9 @@ void grv_schedule_gst_computation_start(grv_server_state_t *state)
 void grv_process_gst_from_root(grv_server_state_t *state,
 		grv_gst_from_root_t *root_gst)
 {
-	struct grv_send_gst_data data = {
-		.state = state,
-		.root_gst = root_gst,
-	};
-	server_foreach_children_partition(&state->server_state, grv_send_gst,
-			&data);
+	server_multicast(&state->server_state, state->config->children_lpids,
+			state->config->num_children, GRV_GST_FROM_ROOT,
+			&root_gst->message);
 	cpu_lock_lock(state->cpu, state->lock_gsv, GRV_GST_FROM_ROOT_LOCKED,
 			root_gst, root_gst->size);
 }
@@ -166,12 +140,84 @@ void grv_process_gst_from_root_unlocked(grv_server_state_t *state)
 	if (server_is_leaf_partition(&state->server_state)) {
 		grv_schedule_gst_computation_start(state);
 	}
-	//FIXME See above FIXME near line 84
-	//garbage_collect(state);
+}
+
+// With the broadcast topology, each partition sends its version vector to all
+// the other partitions of its replica and computes the GSV on its own from the
+// latest vector received from each of them.
+static gr_tsp *partition_lst_vector(grv_server_state_t *state,
+		partition_t partition)
+{
+	return state->partition_lst_vectors
+		+ partition * state->config->cluster->num_replicas;
+}
+
+static void grv_update_gst_vector_from_partitions(grv_server_state_t *state)
+{
+	unsigned int num_replicas = state->config->cluster->num_replicas;
+	memcpy(state->min_lst_vector, partition_lst_vector(state, 0),
+			num_replicas * sizeof(gr_tsp));
+	for (partition_t p = 1; p < state->config->cluster->num_partitions; ++p) {
+		gr_tsp *lst_vector = partition_lst_vector(state, p);
+		for (unsigned int i = 0; i < num_replicas; ++i) {
+			set_min(&state->min_lst_vector[i], lst_vector[i]);
+		}
+	}
+	cpu_add_time(state->cpu,
+			num_replicas * process_lst_from_leaf_end_per_replica_time());
+	if (grv_gst_vector_need_update(state, state->min_lst_vector)) {
+		cpu_lock_lock(state->cpu, state->lock_gsv, GRV_LST_BROADCAST_LOCKED,
+				NULL, 0);
+	}
+}
+
+static void grv_broadcast_lst(grv_server_state_t *state)
+{
+	partition_t partition = state->config->partition;
+	unsigned int num_replicas = state->config->cluster->num_replicas;
+	grv_copy_version_vector(partition_lst_vector(state, partition), state);
+	grv_schedule_gst_computation_start(state);
+
+	grv_lst_from_leaf_t *lst = grv_lst_from_leaf_pooled(
+			state->server_state.messages, num_replicas);
+	grv_copy_version_vector(grv_lst_from_leaf_lst_vector(lst), state);
+	lst->leaf_partition_id = partition;
+	cpu_add_time(state->cpu, build_struct_per_byte_time()
+			* (simtime_t) lst->simulated_size);
+	server_multicast(&state->server_state, state->config->partition_peers,
+			state->config->num_partition_peers, GRV_LST_BROADCAST,
+			&lst->message);
+
+	grv_update_gst_vector_from_partitions(state);
+}
+
+void grv_process_lst_broadcast(grv_server_state_t *state,
+		grv_lst_from_leaf_t *lst)
+{
+	unsigned int num_replicas = state->config->cluster->num_replicas;
+	gr_tsp *lst_vector = partition_lst_vector(state, lst->leaf_partition_id);
+	for (unsigned int i = 0; i < num_replicas; ++i) {
+		set_max(&lst_vector[i], grv_lst_from_leaf_lst_vector(lst)[i]);
+	}
+	cpu_add_time(state->cpu,
+			num_replicas * process_lst_from_leaf_per_replica_time());
+	grv_update_gst_vector_from_partitions(state);
+}
+
+void grv_process_lst_broadcast_locked(grv_server_state_t *state)
+{
+	// min_lst_vector may have increased since the lock was requested, it is
+	// still a lower bound of the vectors of every partition
+	grv_update_gst_vector(state, state->min_lst_vector);
+	cpu_lock_unlock(state->cpu, state->lock_gsv, CPU_NO_EVENT, NULL, 0);
 }
 
 void grv_process_start_gst_computation(grv_server_state_t *state)
 {
+	if (state->config->gst_topology == GST_TOPOLOGY_BROADCAST) {
+		grv_broadcast_lst(state);
+		return;
+	}
 	assert(server_is_leaf_partition(&state->server_state));
 	if (state->config->partition == 0) {
 		// Only one partition
@@ -180,17 +226,14 @@ void grv_process_start_gst_computation(grv_server_state_t *state)
 		return;
 	}
 	unsigned int num_replicas = state->config->cluster->num_replicas;
-	grv_lst_from_leaf_t *leaf_lst = grv_lst_from_leaf_new(num_replicas);
+	grv_lst_from_leaf_t *leaf_lst = grv_lst_from_leaf_pooled(
+			state->server_state.messages, num_replicas);
 	grv_copy_version_vector(grv_lst_from_leaf_lst_vector(leaf_lst), state);
 	leaf_lst->leaf_partition_id = state->config->partition;
-	lpid_t parent_lpid = cluster_get_lpid(
-			state->config->cluster, state->config->replica,
-			server_parent_partition_id(&state->server_state));
 	cpu_add_time(state->cpu, build_struct_per_byte_time()
 			* (simtime_t) leaf_lst->simulated_size);
-	server_send(&state->server_state, parent_lpid, GRV_LST_FROM_LEAF,
-			&leaf_lst->message);
-	free(leaf_lst);
+	server_send(&state->server_state, state->config->parent_lpid,
+			GRV_LST_FROM_LEAF, &leaf_lst->message);
 }
 
 int grv_gst_vector_need_update(grv_server_state_t *state, gr_tsp *gst_vector)
@@ -225,6 +268,7 @@ void grv_update_gst_vector(grv_server_state_t *state, gr_tsp *gst_vector)
 
 	if (increased) {
 		grv_stats_gst_update(state, old_gst_vector, state->gst_vector);
+		grv_garbage_collect(state);
 	}
 
 	free(old_gst_vector);
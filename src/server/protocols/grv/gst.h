@@ -13,6 +13,9 @@ void grv_process_lst_from_leaf(grv_server_state_t *state,
 		grv_lst_from_leaf_t *leaf_lst);
 void grv_process_lst_from_leaf_root_locked(grv_server_state_t *state);
 void grv_process_lst_from_leaf_root_unlocked(grv_server_state_t *state);
+void grv_process_lst_broadcast(grv_server_state_t *state,
+		grv_lst_from_leaf_t *lst);
+void grv_process_lst_broadcast_locked(grv_server_state_t *state);
 void grv_process_start_gst_computation(grv_server_state_t *state);
 void grv_schedule_gst_computation_start(grv_server_state_t *state);
 void grv_send_lst_to_parent(grv_server_state_t *state);
@@ -4,7 +4,10 @@
 #include "event.h"
 #include "gentle_rain.h"
 #include "parameters.h"
+#include "server/protocols/grv/replication.h"
 
+static DEFINE_PROTOCOL_PARAMETER_DEFAULT_FUNC(replication_batch_size, uint, "gr", 0);
+static DEFINE_PROTOCOL_PARAMETER_DEFAULT_FUNC(suppress_redundant_heartbeats, uint, "gr", 0);
 static DEFINE_PROTOCOL_TIMING_FUNC(process_heartbeat_time, "gr");
 
 void grv_process_heartbeat(grv_server_state_t *state, grv_heartbeat_t *heartbeat)
@@ -23,19 +26,32 @@ void grv_process_heartbeat_locked(grv_server_state_t *state,
 
 void grv_send_heartbeat(grv_server_state_t *state, int send_time)
 {
-	grv_heartbeat_t *heartbeat = grv_heartbeat_new();
+	gr_tsp time = send_time ? state->clock : 0;
+	if (suppress_redundant_heartbeats() != 0
+			&& time <= state->replicated_time
+			&& state->replication_batch_count == 0) {
+		// The other replicas already advanced their version vector up to
+		// this time with an update or a previous heartbeat
+		cpu_allow_no_time(state->cpu);
+		return;
+	}
+
+	if (replication_batch_size() > 0) {
+		// Batches are ordered with the updates they follow, the buffered
+		// updates are sent along with the heartbeat
+		grv_flush_replication_batch(state, time);
+		return;
+	}
+
+	grv_heartbeat_t *heartbeat = grv_heartbeat_pooled(
+			state->server_state.messages);
 	heartbeat->replica = state->config->replica;
-	heartbeat->time = send_time ? state->clock : 0;
+	heartbeat->time = time;
+	set_max(&state->replicated_time, time);
 	cpu_add_time(state->cpu, build_struct_per_byte_time()
 			* (simtime_t) heartbeat->size);
 
-	void send_heartbeat_message(lpid_t replica_lpid, replica_t replica) {
-		if (replica == state->config->replica) return;
-		server_send(&state->server_state, replica_lpid, GRV_HEARTBEAT,
-				&heartbeat->message);
-	}
-
-	foreach_replica(state->config->cluster,
-			state->config->partition, send_heartbeat_message);
-	free(heartbeat);
+	server_multicast(&state->server_state, state->config->replica_peers,
+			state->config->num_replica_peers, GRV_HEARTBEAT,
+			&heartbeat->message);
 }
@@ -2,65 +2,127 @@
 #include "event.h"
 #include "messages/grv.h"
 #include "parameters.h"
-#include "queue.h"
 #include "server/protocols/grv/store.h"
 #include "server/stats.h"
 #include <assert.h>
 
+static DEFINE_PROTOCOL_PARAMETER_DEFAULT_FUNC(replication_batch_size, uint, "gr", 0);
+static DEFINE_PROTOCOL_PARAMETER_DEFAULT_FUNC(replication_batch_interval, double, "gr", 0);
+static DEFINE_PROTOCOL_TIMING_FUNC(process_heartbeat_time, "gr");
 static DEFINE_PROTOCOL_TIMING_FUNC(process_replica_update_time, "gr");
 
+// Time and number of updates of a received batch, the updates themselves are
+// in the update queue of the source replica
+typedef struct {
+	unsigned int num_updates;
+	gr_tsp time;
+} batch_header_t;
+
+void grv_replication_init(grv_server_state_t *state)
+{
+	unsigned int num_replicas = state->config->cluster->num_replicas;
+	size_t entry_size = grv_replica_update_entry_size(num_replicas);
+	state->replication_batch = replication_batch_size() == 0 ? NULL
+		: malloc(replication_batch_size() * entry_size);
+	state->replication_batch_count = 0;
+	state->replication_batch_id = 0;
+	state->replicated_time = 0;
+
+	state->replica_update_queues = malloc(num_replicas * sizeof(ring_buffer_t));
+	state->replica_dependency_queues =
+		malloc(num_replicas * sizeof(ring_buffer_t));
+	state->replica_batch_queues = malloc(num_replicas * sizeof(ring_buffer_t));
+	for (unsigned int i = 0; i < num_replicas; ++i) {
+		ring_buffer_init(&state->replica_update_queues[i],
+				sizeof(grv_replica_update_entry_t));
+		ring_buffer_init(&state->replica_dependency_queues[i],
+				num_replicas * sizeof(gr_tsp));
+		ring_buffer_init(&state->replica_batch_queues[i],
+				sizeof(batch_header_t));
+	}
+}
+
+// Whether an update conflicting with the latest local version is older
+// than it and must be ignored
+static int is_overwritten_update(grv_server_state_t *state, gr_key key,
+		gr_tsp update_time, replica_t update_source_replica,
+		gr_tsp previous_update_time, replica_t previous_source_replica)
+{
+	gr_value value;
+	gr_tsp local_update_time;
+	replica_t source_replica;
+	grv_get_value_at(&value, &local_update_time, &source_replica,
+			state, key, 0, grv_always_visible);
+	if (previous_update_time == local_update_time
+			&& previous_source_replica == source_replica) {
+		return 0;
+	}
+	if (update_time < local_update_time ||
+			(update_time == local_update_time
+			 && update_source_replica < source_replica)) {
+		assert(update_source_replica != source_replica);
+		return 1;
+	}
+	return 0;
+}
+
 static void grv_process_replica_update_work(grv_server_state_t *state,
-		grv_replica_update_t *update);
+		replica_t source_replica);
 
 // Process a replication message
 void grv_process_replica_update(grv_server_state_t *state, grv_replica_update_t *update)
 {
-	queue_t *queue = state->replica_update_queues[update->source_replica];
-	int process_immediately = queue_is_empty(queue);
-	grv_replica_update_t *enqueued_update = malloc(update->size);
-	memcpy(enqueued_update, update, update->size);
-	queue_enqueue(queue, enqueued_update);
+	ring_buffer_t *queue = &state->replica_update_queues[update->source_replica];
+	int process_immediately = ring_buffer_is_empty(queue);
+	grv_replica_update_entry_t entry = {
+		.key = update->key,
+		.value = update->value,
+		.update_time = update->update_time,
+		.update_time_no_skew = update->update_time_no_skew,
+		.previous_update_time = update->previous_update_time,
+		.previous_source_replica = update->previous_source_replica,
+	};
+	ring_buffer_push(queue, &entry);
+	ring_buffer_push(&state->replica_dependency_queues[update->source_replica],
+			grv_replica_update_dependency_vector(update));
 	if (process_immediately) {
-		grv_process_replica_update_work(state, update);
+		grv_process_replica_update_work(state, update->source_replica);
 	} else {
 		cpu_allow_no_time(state->cpu);
 	}
 }
 
-void grv_process_replica_update_work(grv_server_state_t *state,
-		grv_replica_update_t *update)
+// Process the update at the head of the queue of the source replica, it
+// stays there until unlocked
+static void grv_process_replica_update_work(grv_server_state_t *state,
+		replica_t source_replica)
 {
-	assert(update->source_replica != state->config->replica);
+	assert(source_replica != state->config->replica);
+	grv_replica_update_entry_t *update =
+		ring_buffer_peek(&state->replica_update_queues[source_replica]);
 	cpu_add_time(state->cpu, process_replica_update_time());
 
-	// Conflict detection
-	gr_value value;
-	gr_tsp update_time;
-	replica_t source_replica;
-	grv_get_value_at(&value, &update_time, &source_replica,
-			state, update->key, 0, grv_always_visible);
-	if (update->previous_update_time != update_time
-			|| update->previous_source_replica != source_replica) {
-		// There is a conflict, ignore the update if it is older
-		if (update->update_time < update_time ||
-				(update->update_time == update_time
-				 && update->source_replica < source_replica)) {
-			assert(update->source_replica != source_replica);
-			grv_process_replica_update_vv_unlocked(state, update);
-			return;
-		}
+	// Conflict detection, the update is ignored if it is older
+	if (is_overwritten_update(state, update->key, update->update_time,
+				source_replica, update->previous_update_time,
+				update->previous_source_replica)) {
+		grv_process_replica_update_vv_unlocked(state, &source_replica);
+		return;
 	}
 
 	cpu_lock_lock(state->cpu, state->lock_vv, GRV_REPLICA_UPDATE_VV_LOCKED,
-			update, update->size);
+			&source_replica, sizeof(replica_t));
 }
 
 void grv_process_replica_update_vv_locked(grv_server_state_t *state,
-		grv_replica_update_t *update)
+		replica_t *source_replica)
 {
+	grv_replica_update_entry_t *update =
+		ring_buffer_peek(&state->replica_update_queues[*source_replica]);
 	grv_put_value(state, update->key, update->value, update->update_time,
-			grv_replica_update_dependency_vector(update), update->source_replica);
-	state->version_vector[update->source_replica] = update->update_time;
+			ring_buffer_peek(&state->replica_dependency_queues[*source_replica]),
+			*source_replica);
+	state->version_vector[*source_replica] = update->update_time;
 
 	server_stats_counter_inc(&state->server_state, REPLICA_UPDATES);
 	simtime_t replication_time = state->now - update->update_time_no_skew;
@@ -69,35 +131,198 @@ void grv_process_replica_update_vv_locked(grv_server_state_t *state,
 			replication_time);
 
 	cpu_lock_unlock(state->cpu, state->lock_vv, GRV_REPLICA_UPDATE_VV_UNLOCKED,
-			update, update->size);
+			source_replica, sizeof(replica_t));
 }
 
 void grv_process_replica_update_vv_unlocked(grv_server_state_t *state,
-		grv_replica_update_t *update)
+		replica_t *source_replica)
+{
+	ring_buffer_t *queue = &state->replica_update_queues[*source_replica];
+	ring_buffer_shift(queue);
+	ring_buffer_shift(&state->replica_dependency_queues[*source_replica]);
+	if (!ring_buffer_is_empty(queue)) {
+		grv_process_replica_update_work(state, *source_replica);
+	} else {
+		cpu_allow_no_time(state->cpu);
+	}
+}
+
+static void grv_process_replica_update_batch_work(grv_server_state_t *state,
+		replica_t source_replica);
+
+void grv_process_replica_update_batch(grv_server_state_t *state,
+		grv_replica_update_batch_t *batch)
 {
-	queue_t *queue = state->replica_update_queues[update->source_replica];
-	grv_replica_update_t *enqueued_update = queue_dequeue(queue);
-	assert(enqueued_update != NULL);
-	assert(enqueued_update->key == update->key);
-	assert(enqueued_update->value == update->value);
-	assert(enqueued_update->update_time == update->update_time);
-	assert(enqueued_update->source_replica == update->source_replica);
-	free(enqueued_update);
-
-	enqueued_update = queue_peek(queue);
-	if (enqueued_update != NULL) {
-		grv_process_replica_update_work(state, enqueued_update);
+	ring_buffer_t *queue = &state->replica_batch_queues[batch->source_replica];
+	int process_immediately = ring_buffer_is_empty(queue);
+	for (unsigned int i = 0; i < batch->num_updates; ++i) {
+		grv_replica_update_entry_t *update =
+			grv_replica_update_batch_update(batch, i);
+		ring_buffer_push(&state->replica_update_queues[batch->source_replica],
+				update);
+		ring_buffer_push(&state->replica_dependency_queues[batch->source_replica],
+				grv_replica_update_entry_dependency_vector(update));
+	}
+	batch_header_t header = {
+		.num_updates = batch->num_updates,
+		.time = batch->time,
+	};
+	ring_buffer_push(queue, &header);
+	if (process_immediately) {
+		grv_process_replica_update_batch_work(state, batch->source_replica);
 	} else {
 		cpu_allow_no_time(state->cpu);
 	}
 }
 
+static void grv_process_replica_update_batch_work(grv_server_state_t *state,
+		replica_t source_replica)
+{
+	assert(source_replica != state->config->replica);
+	batch_header_t *batch =
+		ring_buffer_peek(&state->replica_batch_queues[source_replica]);
+	cpu_add_time(state->cpu, process_heartbeat_time());
+	if (batch->num_updates > 0
+			|| state->version_vector[source_replica] < batch->time) {
+		cpu_lock_lock(state->cpu, state->lock_vv,
+				GRV_REPLICA_UPDATE_BATCH_VV_LOCKED, &source_replica,
+				sizeof(replica_t));
+	} else {
+		grv_process_replica_update_batch_vv_unlocked(state, &source_replica);
+	}
+}
+
+void grv_process_replica_update_batch_vv_locked(grv_server_state_t *state,
+		replica_t *source_replica)
+{
+	ring_buffer_t *updates = &state->replica_update_queues[*source_replica];
+	ring_buffer_t *dependency_vectors =
+		&state->replica_dependency_queues[*source_replica];
+	batch_header_t *batch =
+		ring_buffer_peek(&state->replica_batch_queues[*source_replica]);
+	for (unsigned int i = 0; i < batch->num_updates; ++i) {
+		grv_replica_update_entry_t *update = ring_buffer_get(updates, i);
+		cpu_add_time(state->cpu, process_replica_update_time());
+		if (is_overwritten_update(state, update->key, update->update_time,
+					*source_replica, update->previous_update_time,
+					update->previous_source_replica)) {
+			continue;
+		}
+		grv_put_value(state, update->key, update->value, update->update_time,
+				ring_buffer_get(dependency_vectors, i), *source_replica);
+
+		server_stats_counter_inc(&state->server_state, REPLICA_UPDATES);
+		simtime_t replication_time = state->now - update->update_time_no_skew;
+		assert(replication_time > 0);
+		server_stats_array_push(&state->server_state, REPLICATION_TIME,
+				replication_time);
+	}
+	set_max(&state->version_vector[*source_replica], batch->time);
+
+	cpu_lock_unlock(state->cpu, state->lock_vv,
+			GRV_REPLICA_UPDATE_BATCH_VV_UNLOCKED, source_replica,
+			sizeof(replica_t));
+}
+
+void grv_process_replica_update_batch_vv_unlocked(grv_server_state_t *state,
+		replica_t *source_replica)
+{
+	ring_buffer_t *queue = &state->replica_batch_queues[*source_replica];
+	batch_header_t *batch = ring_buffer_peek(queue);
+	for (unsigned int i = 0; i < batch->num_updates; ++i) {
+		ring_buffer_shift(&state->replica_update_queues[*source_replica]);
+		ring_buffer_shift(&state->replica_dependency_queues[*source_replica]);
+	}
+	ring_buffer_shift(queue);
+	if (!ring_buffer_is_empty(queue)) {
+		grv_process_replica_update_batch_work(state, *source_replica);
+	} else {
+		cpu_allow_no_time(state->cpu);
+	}
+}
+
+void grv_flush_replication_batch(grv_server_state_t *state, gr_tsp time)
+{
+	unsigned int num_replicas = state->config->cluster->num_replicas;
+	unsigned int num_updates = state->replication_batch_count;
+	grv_replica_update_batch_t *batch = grv_replica_update_batch_pooled(
+			state->server_state.messages, num_updates, num_replicas);
+	batch->source_replica = state->config->replica;
+	memcpy(grv_replica_update_batch_update(batch, 0), state->replication_batch,
+			num_updates * grv_replica_update_entry_size(num_replicas));
+	for (unsigned int i = 0; i < num_updates; ++i) {
+		set_max(&time, grv_replica_update_batch_update(batch, i)->update_time);
+	}
+	batch->time = time;
+	set_max(&state->replicated_time, time);
+	cpu_add_time(state->cpu, build_struct_per_byte_time()
+			* (simtime_t) batch->simulated_size);
+
+	server_multicast(&state->server_state, state->config->replica_peers,
+			state->config->num_replica_peers, GRV_REPLICA_UPDATE_BATCH,
+			&batch->message);
+
+	state->replication_batch_count = 0;
+	++state->replication_batch_id;
+}
+
+void grv_process_replication_batch_timeout(grv_server_state_t *state,
+		unsigned int *batch_id)
+{
+	// The batch may already have been flushed because it was full or by a
+	// heartbeat
+	if (*batch_id == state->replication_batch_id
+			&& state->replication_batch_count > 0) {
+		grv_flush_replication_batch(state, 0);
+	} else {
+		cpu_allow_no_time(state->cpu);
+	}
+}
+
+// Buffer an update until the batch is full or its interval elapses
+static void grv_batch_value(grv_server_state_t *state, gr_key key,
+		gr_value value, gr_tsp update_time, gr_tsp *dependency_vector,
+		gr_tsp previous_update_time, replica_t previous_source_replica,
+		gr_tsp update_time_no_skew)
+{
+	unsigned int num_replicas = state->config->cluster->num_replicas;
+	grv_replica_update_entry_t *update = (grv_replica_update_entry_t*)
+		(state->replication_batch + state->replication_batch_count
+		 * grv_replica_update_entry_size(num_replicas));
+	update->key = key;
+	update->value = value;
+	update->update_time = update_time;
+	update->update_time_no_skew = update_time_no_skew;
+	update->previous_update_time = previous_update_time;
+	update->previous_source_replica = previous_source_replica;
+	memcpy(grv_replica_update_entry_dependency_vector(update),
+			dependency_vector, num_replicas * sizeof(gr_tsp));
+
+	if (++state->replication_batch_count == replication_batch_size()) {
+		grv_flush_replication_batch(state, 0);
+	} else if (state->replication_batch_count == 1
+			&& replication_batch_interval() > 0) {
+		server_schedule_self(&state->server_state,
+				replication_batch_interval(), GRV_REPLICATION_BATCH_TIMEOUT,
+				&state->replication_batch_id, sizeof(unsigned int));
+	}
+}
+
 void grv_replicate_value(grv_server_state_t *state, gr_key key, gr_value value,
 		gr_tsp update_time, gr_tsp *dependency_vector, replica_t source_replica,
 		gr_tsp previous_update_time, replica_t previous_source_replica,
 		gr_tsp update_time_no_skew)
 {
-	grv_replica_update_t *update = grv_replica_update_new(
+	if (replication_batch_size() > 0) {
+		assert(source_replica == state->config->replica);
+		grv_batch_value(state, key, value, update_time, dependency_vector,
+				previous_update_time, previous_source_replica,
+				update_time_no_skew);
+		return;
+	}
+
+	grv_replica_update_t *update = grv_replica_update_pooled(
+			state->server_state.messages,
 			state->config->cluster->num_replicas);
 	memcpy(grv_replica_update_dependency_vector(update),
 			dependency_vector,
@@ -109,16 +334,11 @@ void grv_replicate_value(grv_server_state_t *state, gr_key key, gr_value value,
 	update->source_replica = source_replica;
 	update->previous_update_time = previous_update_time;
 	update->previous_source_replica = previous_source_replica;
+	set_max(&state->replicated_time, update_time);
 	cpu_add_time(state->cpu, build_struct_per_byte_time()
 			* (simtime_t) update->simulated_size);
 
-	void send_update(lpid_t replica_lpid, replica_t replica) {
-		if (replica == state->config->replica) return;
-		server_send(&state->server_state, replica_lpid, GRV_REPLICA_UPDATE,
-				&update->message);
-	}
-	foreach_replica(state->config->cluster, state->config->partition,
-			send_update);
-
-	free(update);
+	server_multicast(&state->server_state, state->config->replica_peers,
+			state->config->num_replica_peers, GRV_REPLICA_UPDATE,
+			&update->message);
 }
@@ -11,14 +11,26 @@
 #include "server/protocols/grv/grv.h"
 #include "server/protocols/grv/store.h"
 
+void grv_replication_init(grv_server_state_t *state);
 void grv_replicate_value(grv_server_state_t *state, gr_key key, gr_value value,
 		gr_tsp update_time, gr_tsp *dependency_vector, replica_t source_replica,
 		gr_tsp previous_update_time, replica_t previous_source_replica,
 		gr_tsp update_time_no_skew);
 void grv_process_replica_update(grv_server_state_t *state, grv_replica_update_t *update);
 void grv_process_replica_update_vv_locked(grv_server_state_t *state,
-		grv_replica_update_t *update);
+		replica_t *source_replica);
 void grv_process_replica_update_vv_unlocked(grv_server_state_t *state,
-		grv_replica_update_t *update);
+		replica_t *source_replica);
+
+/* Batched replication, see server/protocols/gr/replication.h. */
+void grv_process_replica_update_batch(grv_server_state_t *state,
+		grv_replica_update_batch_t *batch);
+void grv_process_replica_update_batch_vv_locked(grv_server_state_t *state,
+		replica_t *source_replica);
+void grv_process_replica_update_batch_vv_unlocked(grv_server_state_t *state,
+		replica_t *source_replica);
+void grv_process_replication_batch_timeout(grv_server_state_t *state,
+		unsigned int *batch_id);
+void grv_flush_replication_batch(grv_server_state_t *state, gr_tsp time);
 
 #endif
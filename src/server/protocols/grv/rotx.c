@@ -5,6 +5,7 @@
 #include "messages/grv.h"
 #include "parameters.h"
 #include "server/protocols/grv/gst.h"
+#include "server/protocols/grv/slice.h"
 #include "server/protocols/grv/store.h"
 #include <assert.h>
 #include <limits.h>
@@ -12,6 +13,7 @@
 #define NO_SLOT_FOUND UINT_MAX
 
 static DEFINE_PROTOCOL_TIMING_FUNC(process_rotx_request_per_partition_time, "grv");
+static DEFINE_PROTOCOL_PARAMETER_DEFAULT_FUNC(local_slice_reads, uint, "gr", 0);
 
 static unsigned int grv_rotx_state_new(grv_server_state_t *state,
 		unsigned int num_keys)
@@ -73,6 +75,9 @@ void grv_process_rotx_request_unlocked(grv_server_state_t *state,
 	gr_tsp snapshot_time = state->clock > request->dependency_time ?
 		state->clock : request->dependency_time;
 	unsigned int num_replicas = state->config->cluster->num_replicas;
+	// Local keys can only be read right away if the snapshot is not ahead of
+	// the local clock, otherwise the slice request has to wait for it.
+	int read_locally = local_slice_reads() != 0 && snapshot_time <= state->clock;
 
 	void send_slice(lpid_t partition_lpid, partition_t partition) {
 		(void) partition; // Unused parameter
@@ -82,8 +87,10 @@ void grv_process_rotx_request_unlocked(grv_server_state_t *state,
 		}
 		cpu_add_time(state->cpu, process_rotx_request_per_partition_time());
 		if (num_keys == 0) return;
+		if (read_locally && partition_lpid == state->config->lpid) return;
 
-		grv_slice_request_t *slice = grv_slice_request_new(num_keys, num_replicas);
+		grv_slice_request_t *slice = grv_slice_request_pooled(
+				state->server_state.messages, num_keys, num_replicas);
 		slice->rotx_id = rotx_id;
 		slice->from_lpid = state->config->lpid;
 		slice->snapshot_time = snapshot_time;
@@ -102,16 +109,19 @@ void grv_process_rotx_request_unlocked(grv_server_state_t *state,
 				* (simtime_t) slice->size);
 		server_send(&state->server_state, partition_lpid, GRV_SLICE_REQUEST,
 				&slice->message);
-		free(slice);
 	}
 	foreach_partition(state->config->cluster, state->config->replica,
 			send_slice);
+	if (read_locally) {
+		grv_read_local_slice(state, rotx_id, keys, request->num_keys);
+	}
 }
 
 void grv_send_rotx_response(grv_server_state_t *state, unsigned int rotx_id)
 {
 	grv_rotx_state_t *rotx = grv_rotx_state_get(state, rotx_id);
-	grv_rotx_response_t *response = grv_rotx_response_new(
+	grv_rotx_response_t *response = grv_rotx_response_pooled(
+			state->server_state.messages,
 			rotx->num_values, state->config->cluster->num_replicas);
 	memcpy(grv_rotx_response_values(response), rotx->values,
 			rotx->num_values * sizeof(*rotx->values));
@@ -122,6 +132,5 @@ void grv_send_rotx_response(grv_server_state_t *state, unsigned int rotx_id)
 	server_send(&state->server_state, rotx->client_lpid, GRV_ROTX_RESPONSE,
 			&response->message);
 	server_stats_counter_inc(&state->server_state, ROTX_REQUESTS);
-	free(response);
 	grv_rotx_state_free(state, rotx_id);
 }
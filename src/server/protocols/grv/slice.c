@@ -10,6 +10,7 @@
 
 static DEFINE_PROTOCOL_TIMING_FUNC(process_slice_response_per_value_time, "gr");
 static DEFINE_PROTOCOL_TIMING_FUNC(is_value_visible_time, "gr");
+static DEFINE_PROTOCOL_TIMING_FUNC(local_slice_read_per_value_time, "gr");
 
 static int is_value_visible_snapshot(grv_server_state_t *state, item_t *item,
 		gr_tsp *time_vector)
@@ -56,7 +57,8 @@ void grv_process_slice_request_unlocked(grv_server_state_t *state,
 	gr_tsp *snapshot_vector = malloc(num_replicas * sizeof(gr_tsp));
 	grv_copy_gst_vector(snapshot_vector, state);
 	snapshot_vector[state->config->replica] = state->clock;
-	grv_slice_response_t *response = grv_slice_response_new(request->num_keys);
+	grv_slice_response_t *response = grv_slice_response_pooled(
+			state->server_state.messages, request->num_keys);
 	response->rotx_id = request->rotx_id;
 	gr_key *keys = grv_slice_request_keys(request);
 	gr_value *values = grv_slice_response_values(response);
@@ -74,7 +76,33 @@ void grv_process_slice_request_unlocked(grv_server_state_t *state,
 	server_send(&state->server_state, request->from_lpid, GRV_SLICE_RESPONSE,
 			&response->message);
 	free(snapshot_vector);
-	free(response);
+}
+
+void grv_read_local_slice(grv_server_state_t *state, unsigned int rotx_id,
+		gr_key *keys, unsigned int num_keys)
+{
+	grv_rotx_state_t *rotx = grv_rotx_state_get(state, rotx_id);
+	unsigned int num_replicas = state->config->cluster->num_replicas;
+	gr_tsp *snapshot_vector = malloc(num_replicas * sizeof(gr_tsp));
+	grv_copy_gst_vector(snapshot_vector, state);
+	snapshot_vector[state->config->replica] = state->clock;
+	unsigned int num_values = 0;
+	for (unsigned int k = 0; k < num_keys; ++k) {
+		if (grv_lpid_for_key(keys[k], state) != state->config->lpid) continue;
+		gr_tsp update_time;
+		replica_t source_replica;
+		grv_get_value_at(&rotx->values[k], &update_time, &source_replica,
+				state, keys[k], snapshot_vector, is_value_visible_snapshot);
+		set_max(&rotx->dependency_vector[source_replica], update_time);
+		++num_values;
+	}
+	free(snapshot_vector);
+	if (num_values == 0) return;
+	rotx->received_values += num_values;
+	cpu_add_time(state->cpu, num_values * local_slice_read_per_value_time());
+	if (rotx->received_values == rotx->num_values) {
+		grv_send_rotx_response(state, rotx_id);
+	}
 }
 
 void grv_process_slice_response(grv_server_state_t *state, grv_slice_response_t *slice)
@@ -17,4 +17,10 @@ void grv_process_slice_request_locked(grv_server_state_t *state,
 void grv_process_slice_request_unlocked(grv_server_state_t *state,
 		grv_slice_request_t *request);
 
+/* Read the given keys of a ROTX owned by this server directly instead of
+ * sending a slice request to itself, the snapshot time must not be ahead of
+ * the local clock. */
+void grv_read_local_slice(grv_server_state_t *state, unsigned int rotx_id,
+		gr_key *keys, unsigned int num_keys);
+
 #endif
@@ -8,6 +8,153 @@
 static DEFINE_PROTOCOL_TIMING_FUNC(get_value_time, "gr");
 static DEFINE_PROTOCOL_TIMING_FUNC(put_value_time, "gr");
 static DEFINE_PROTOCOL_TIMING_FUNC(is_value_visible_time, "gr");
+static DEFINE_PROTOCOL_TIMING_FUNC(garbage_collect_per_version_time, "gr");
+static DEFINE_PROTOCOL_PARAMETER_DEFAULT_FUNC(gc_keys_per_round, uint, "gr", 0);
+
+#define ITEMS_PER_SLAB 64
+
+/* Size of an item followed by its dependency vector */
+static size_t item_size(grv_server_state_t *state)
+{
+	return sizeof(item_t)
+		+ state->config->cluster->num_replicas * sizeof(gr_tsp);
+}
+
+/* Versions are allocated by slabs, each item being directly followed by its
+ * dependency vector, and recycled through a free list linked by their
+ * previous_version pointer. */
+static item_t *item_new(grv_server_state_t *state)
+{
+	if (state->free_items == NULL) {
+		size_t size = item_size(state);
+		char *slab = malloc(ITEMS_PER_SLAB * size);
+		for (unsigned int i = 0; i < ITEMS_PER_SLAB; ++i) {
+			item_t *item = (item_t*) (slab + i * size);
+			item->dependency_vector = (gr_tsp*) (item + 1);
+			item->previous_version = state->free_items;
+			state->free_items = item;
+		}
+	}
+	item_t *item = state->free_items;
+	state->free_items = item->previous_version;
+	return item;
+}
+
+static void item_free_chain(grv_server_state_t *state, item_t *first)
+{
+	item_t *last = first;
+	while (last->previous_version != NULL) {
+		last = last->previous_version;
+	}
+	last->previous_version = state->free_items;
+	state->free_items = first;
+}
+
+/* With the "inline_versions" cluster parameter set to K > 0, the store maps
+ * each key to a block keeping its K latest versions, with their dependency
+ * vectors, in a ring so that walking through recent versions touches
+ * contiguous memory. Older versions spill to separately allocated items.
+ * Either way, versions are linked from the latest to the oldest through
+ * previous_version. */
+typedef struct version_block {
+	unsigned int latest; // Slot of the latest version
+	unsigned int count; // Number of versions in the ring
+	_Alignas(item_t) char slots[];
+} version_block_t;
+
+static unsigned int inline_versions(grv_server_state_t *state)
+{
+	return state->config->cluster->inline_versions;
+}
+
+static item_t *block_slot(grv_server_state_t *state, version_block_t *block,
+		unsigned int slot)
+{
+	return (item_t*) (block->slots + slot * item_size(state));
+}
+
+static int is_inline(grv_server_state_t *state, version_block_t *block,
+		item_t *item)
+{
+	return (char*) item >= block->slots
+		&& (char*) item < block->slots + inline_versions(state) * item_size(state);
+}
+
+item_t *grv_stored_latest_version(grv_server_state_t *state, void *value)
+{
+	if (value == NULL || inline_versions(state) == 0) return value;
+	version_block_t *block = value;
+	return block_slot(state, block, block->latest);
+}
+
+item_t *grv_latest_version(grv_server_state_t *state, gr_key key)
+{
+	return grv_stored_latest_version(state, store_get(state->store, key));
+}
+
+/* Store a new version of the key whose other fields, including the content of
+ * the dependency vector, are left to the caller. */
+static item_t *new_version(grv_server_state_t *state, gr_key key,
+		item_t *previous_version)
+{
+	unsigned int k = inline_versions(state);
+	if (k == 0) {
+		item_t *item = item_new(state);
+		item->previous_version = previous_version;
+		store_put(state->store, key, item);
+		return item;
+	}
+	version_block_t *block = store_get(state->store, key);
+	if (block == NULL) {
+		block = malloc(sizeof(version_block_t) + k * item_size(state));
+		block->latest = k - 1;
+		block->count = 0;
+		for (unsigned int i = 0; i < k; ++i) {
+			item_t *slot = block_slot(state, block, i);
+			slot->dependency_vector = (gr_tsp*) (slot + 1);
+		}
+		store_put(state->store, key, block);
+	}
+	if (block->count == k) {
+		// Spill the oldest inline version to make room for the new one
+		unsigned int oldest = (block->latest + 1) % k;
+		item_t *oldest_item = block_slot(state, block, oldest);
+		item_t *spilled = item_new(state);
+		gr_tsp *spilled_vector = spilled->dependency_vector;
+		*spilled = *oldest_item;
+		spilled->dependency_vector = spilled_vector;
+		memcpy(spilled_vector, oldest_item->dependency_vector,
+				state->config->cluster->num_replicas * sizeof(gr_tsp));
+		if (previous_version == oldest_item) {
+			previous_version = spilled;
+		} else {
+			block_slot(state, block, (oldest + 1) % k)->previous_version = spilled;
+		}
+		--block->count;
+	}
+	block->latest = (block->latest + 1) % k;
+	++block->count;
+	item_t *item = block_slot(state, block, block->latest);
+	item->previous_version = previous_version;
+	return item;
+}
+
+/* Free all the versions of the key older than the given one. */
+static void truncate_versions(grv_server_state_t *state, gr_key key,
+		item_t *item)
+{
+	item_t *older = item->previous_version;
+	item->previous_version = NULL;
+	if (inline_versions(state) > 0) {
+		// Inline versions all come before the spilled ones
+		version_block_t *block = store_get(state->store, key);
+		while (older != NULL && is_inline(state, block, older)) {
+			--block->count;
+			older = older->previous_version;
+		}
+	}
+	if (older != NULL) item_free_chain(state, older);
+}
 
 lpid_t grv_lpid_for_key(gr_key key, grv_server_state_t *state) {
 	partition_t partition = partition_for_key(state->config->cluster, key);
@@ -15,10 +162,57 @@ lpid_t grv_lpid_for_key(gr_key key, grv_server_state_t *state) {
 			state->config->replica, partition);
 }
 
+/* Whether the version is visible to any read from now on: reads are done at a
+ * vector at least equal to the GST vector whose local entry is at least the
+ * current clock. */
+static int is_stable(grv_server_state_t *state, item_t *item)
+{
+	for (replica_t i = 0; i < state->config->cluster->num_replicas; ++i) {
+		gr_tsp stable_time = i == state->config->replica
+			? state->clock : state->gst_vector[i];
+		if (item->dependency_vector[i] > stable_time) return 0;
+	}
+	return 1;
+}
+
+/* Free the versions of the key that cannot be read anymore: the latest version
+ * and the previous one are always kept, older ones only down to the first
+ * stable version. Return whether more than two versions remain. */
+static int garbage_collect_key(grv_server_state_t *state, gr_key key,
+		item_t *latest)
+{
+	unsigned int num_visited = 0;
+	item_t *item = latest->previous_version;
+	while (item != NULL) {
+		++num_visited;
+		if (is_stable(state, item)) {
+			if (item->previous_version != NULL) {
+				truncate_versions(state, key, item);
+			}
+			break;
+		}
+		item = item->previous_version;
+	}
+	cpu_add_time(state->cpu, num_visited * garbage_collect_per_version_time());
+	return latest->previous_version != NULL
+		&& latest->previous_version->previous_version != NULL;
+}
+
 void grv_garbage_collect(grv_server_state_t *state)
 {
-	// FIXME Implement garbage collection in the vector case
-	(void) state;
+	unsigned int num_keys = ring_buffer_size(&state->gc_keys);
+	if (num_keys > gc_keys_per_round()) num_keys = gc_keys_per_round();
+	for (unsigned int i = 0; i < num_keys; ++i) {
+		gr_key key = *(gr_key*) ring_buffer_peek(&state->gc_keys);
+		ring_buffer_shift(&state->gc_keys);
+		item_t *latest = grv_latest_version(state, key);
+		if (garbage_collect_key(state, key, latest)) {
+			// Versions too recent to be collected yet, retry in a later round
+			ring_buffer_push(&state->gc_keys, &key);
+		} else {
+			latest->gc_pending = 0;
+		}
+	}
 }
 
 int grv_is_value_visible(grv_server_state_t *state, item_t *item, gr_tsp *gst_vector)
@@ -50,7 +244,7 @@ void grv_get_value_at(gr_value *value_ptr, gr_tsp *update_time_ptr,
 		)
 {
 	assert(grv_lpid_for_key(key, state) == state->config->lpid);
-	item_t *item = store_get(state->store, key);
+	item_t *item = grv_latest_version(state, key);
 	assert(item == NULL || item->source_replica < state->config->cluster->num_replicas);
 	while (item != NULL && !is_visible(state, item, time)) {
 		assert(item->source_replica < state->config->cluster->num_replicas);
@@ -83,29 +277,33 @@ item_t *grv_put_value(grv_server_state_t *state, gr_key key, gr_value value,
 	assert(grv_lpid_for_key(key, state) == state->config->lpid);
 	cpu_add_time(state->cpu, put_value_time());
 
-	item_t *previous_version = store_get(state->store, key);
-	item_t *item = malloc(sizeof(item_t));
-	item->value = value;
-	item->update_time = update_time;
-	item->source_replica = source_replica;
-	item->previous_version = previous_version;
+	item_t *previous_version = grv_latest_version(state, key);
 
 	// Due to clock skew it is possible for the new value to be older in which
 	// case there is a conflict and the old values is ignored
 	if (previous_version != NULL
-			&& previous_version->update_time > item->update_time) {
-		free(item);
+			&& previous_version->update_time > update_time) {
 		return NULL;
 	}
 
+	item_t *item = new_version(state, key, previous_version);
+	previous_version = item->previous_version; // May have been spilled
+	item->value = value;
+	item->update_time = update_time;
+	item->source_replica = source_replica;
+	item->gc_pending = previous_version != NULL && previous_version->gc_pending;
+	// Only keys with more than two versions have something to collect
+	if (!item->gc_pending && gc_keys_per_round() > 0
+			&& previous_version != NULL
+			&& previous_version->previous_version != NULL) {
+		item->gc_pending = 1;
+		ring_buffer_push(&state->gc_keys, &key);
+	}
+
 	unsigned int num_replicas = state->config->cluster->num_replicas;
-	item->dependency_vector = malloc(
-			num_replicas * sizeof(*item->dependency_vector));
 	memcpy(item->dependency_vector, dependency_vector,
 			num_replicas * sizeof(*item->dependency_vector));
 	cpu_add_time(state->cpu, (simtime_t) (2 * num_replicas * sizeof(gr_tsp))
 			* build_struct_per_byte_time());
-
-	store_put(state->store, key, item);
 	return item;
 }
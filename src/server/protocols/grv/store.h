@@ -8,10 +8,22 @@ typedef struct item {
 	gr_tsp update_time;
 	gr_tsp *dependency_vector;
 	replica_t source_replica;
+	// Only meaningful for the latest version, whether the key is queued for
+	// garbage collection.
+	unsigned int gc_pending;
 	struct item *previous_version;
 } item_t;
 
 lpid_t grv_lpid_for_key(gr_key key, grv_server_state_t *state);
+
+/* Return the latest version of the key or NULL if there is none. */
+item_t *grv_latest_version(grv_server_state_t *state, gr_key key);
+
+/* Same as grv_latest_version() given the value stored for the key. */
+item_t *grv_stored_latest_version(grv_server_state_t *state, void *value);
+
+/* Collect the old versions of a bounded number of keys, to be called after the
+ * GST vector has been updated. */
 void grv_garbage_collect(grv_server_state_t *state);
 int grv_is_value_visible(grv_server_state_t *state, item_t *item, gr_tsp *gst_vector);
 
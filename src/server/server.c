@@ -19,40 +19,36 @@
 static DEFINE_TIMING_FUNC(server_send_time);
 static DEFINE_TIMING_FUNC(server_send_per_byte_time);
 
+// lp_config is read-only outside of application.c, keep the configurations
+// writable until the peer tables are filled.
+static server_config_t *server_configs[MAX_LP];
+
+static store_t *server_new_store(const server_config_t *config)
+{
+	cluster_config_t *cluster = config->cluster;
+	if (!cluster->dense_store) return store_new();
+	// Keys of a partition are congruent to it modulo the number of partitions.
+	return store_new_dense(config->partition, cluster->num_partitions,
+			cluster_num_keys_on_partition(cluster, config->partition));
+}
+
 static void server_init(lpid_t lpid, simtime_t now, server_state_t *state)
 {
 	state->config = lp_config[lpid];
 	state->clock = now;
 	state->now = now;
-	state->store = store_new();
+	state->store = server_new_store(state->config);
 	state->stats = server_stats_new();
+	state->messages = message_pool_new();
 	state->start_time = now;
 	state->finished = 0;
-	state->network = network_init(state->config->network);
+	// Other partitions of the replica, other replicas of the partition and
+	// at least one client.
+	state->network = network_init(state->config->network,
+			state->config->cluster->num_partitions
+			+ state->config->cluster->num_replicas);
 
-	// Set network delay to all other servers
 	struct json_object *network_obj = param_get_object_root("network");
-	struct json_object *inter_replica_delay_matrix =
-		param_get_double_matrix(network_obj, "inter_datacenter_delay",
-				state->config->cluster->num_replicas,
-				state->config->cluster->num_replicas);
-	double intra_datacenter_network_delay = param_get_double(
-			network_obj, "intra_datacenter_delay");
-	double self_network_delay = param_get_double(network_obj, "self_delay");
-	void set_network_delay(lpid_t other_lpid, replica_t replica, partition_t partition) {
-		if (replica == state->config->replica) {
-			network_set_delay(state->config->network, state->config->lpid,
-					other_lpid, intra_datacenter_network_delay);
-		} else if (partition == state->config->partition) {
-			double delay = param_get_double_matrix_element(
-						inter_replica_delay_matrix, state->config->replica,
-						replica);
-			network_set_delay(state->config->network, state->config->lpid,
-					other_lpid, delay);
-		}
-	}
-	foreach_server(state->config->cluster, set_network_delay);
-	network_set_delay(state->config->network, lpid, lpid, self_network_delay);
 	double transmission_rate = param_get_double(network_obj, "transmission_rate");
 	network_set_transmission_rate(state->config->network, lpid, transmission_rate);
 
@@ -165,9 +161,18 @@ void server_send(server_state_t *state, lpid_t to_lpid,
 			event_type, message, message->size, message->simulated_size);
 }
 
+void server_multicast(server_state_t *state, const lpid_t *to_lpids,
+		unsigned int num_lpids, unsigned int event_type, message_t *message)
+{
+	for (unsigned int i = 0; i < num_lpids; ++i) {
+		server_send(state, to_lpids[i], event_type, message);
+	}
+}
+
 void server_setup(lpid_t lpid, cluster_config_t *cluster, replica_t replica,
 		partition_t partition, network_config_t *network,
-		unsigned int tree_fanout, unsigned int num_cores)
+		unsigned int tree_fanout, gst_topology_t gst_topology,
+		unsigned int num_cores)
 {
 	assert(replica < cluster->num_replicas);
 	assert(partition < cluster->num_partitions);
@@ -180,12 +185,53 @@ void server_setup(lpid_t lpid, cluster_config_t *cluster, replica_t replica,
 	config->partition = partition;
 	config->network = network;
 	config->tree_fanout = tree_fanout;
+	config->gst_topology = gst_topology;
 	config->num_cores = num_cores;
 	lp_config[lpid] = config;
+	server_configs[lpid] = config;
+	network_set_server_location(network, lpid, replica, partition);
 
 	register_callbacks(lpid, server_process_event, server_on_gvt);
 }
 
+void server_setup_peers(lpid_t lpid)
+{
+	void *__real_malloc(size_t size);
+	server_config_t *config = server_configs[lpid];
+	cluster_config_t *cluster = config->cluster;
+
+	config->replica_peers =
+		__real_malloc(cluster->num_replicas * sizeof(lpid_t));
+	config->num_replica_peers = 0;
+	for (replica_t r = 0; r < cluster->num_replicas; ++r) {
+		if (r == config->replica) continue;
+		config->replica_peers[config->num_replica_peers++] =
+			cluster_get_lpid(cluster, r, config->partition);
+	}
+
+	config->partition_peers =
+		__real_malloc(cluster->num_partitions * sizeof(lpid_t));
+	config->num_partition_peers = 0;
+	for (partition_t p = 0; p < cluster->num_partitions; ++p) {
+		if (p == config->partition) continue;
+		config->partition_peers[config->num_partition_peers++] =
+			cluster_get_lpid(cluster, config->replica, p);
+	}
+
+	config->parent_lpid = config->partition == 0 ? lpid
+		: cluster_get_lpid(cluster, config->replica,
+				(config->partition - 1) / config->tree_fanout);
+	config->children_lpids =
+		__real_malloc(config->tree_fanout * sizeof(lpid_t));
+	config->num_children = 0;
+	for (unsigned int i = 0; i < config->tree_fanout; ++i) {
+		partition_t child = config->partition * config->tree_fanout + 1 + i;
+		if (child >= cluster->num_partitions) break;
+		config->children_lpids[config->num_children++] =
+			cluster_get_lpid(cluster, config->replica, child);
+	}
+}
+
 unsigned int server_parent_partition_id(server_state_t *state)
 {
 	assert(state->config->partition != 0);
@@ -218,27 +264,5 @@ int server_is_leaf_partition(server_state_t *state)
 
 unsigned int server_num_children_partitions(server_state_t *state)
 {
-	unsigned int num_children = 0;
-	unsigned int last_child_id = server_last_child_id(state);
-	unsigned int first_child_id = server_first_child_id(state);
-	if (last_child_id < state->config->cluster->num_partitions) {
-		num_children =  state->config->tree_fanout;
-	} else {
-		if (first_child_id < state->config->cluster->num_partitions) {
-			num_children = state->config->tree_fanout
-				- (last_child_id - state->config->cluster->num_partitions + 1);
-		}
-	}
-	return num_children;
-}
-
-void server_foreach_children_partition(server_state_t *state,
-		void (*f)(partition_t partition, void *data), void *data)
-{
-	for (unsigned int i = server_first_child_id(state);
-			i <= server_last_child_id(state)
-				&& i < state->config->cluster->num_partitions;
-			++i) {
-		f(i, data);
-	}
+	return state->config->num_children;
 }
@@ -12,6 +12,7 @@ typedef struct server_state server_state_t;
 #include "cluster.h"
 #include "cpu/cpu.h"
 #include "messages/message.h"
+#include "messages/pool.h"
 #include "network.h"
 #include "server/clock_skew.h"
 #include "server/stats.h"
@@ -42,7 +43,33 @@ typedef struct server_state server_state_t;
  *  .. c:member:: int tree_fanout
  *
  *  The fanout of the tree into which the partitions are arranged.
+ *
+ *  .. c:member:: gst_topology_t gst_topology
+ *
+ *  How the partitions of a replica exchange their LSTs to compute the GST.
+ *
+ *  .. c:member:: lpid_t *replica_peers
+ *
+ *  The lpids of the servers of the same partition in the other replicas, by
+ *  replica. Filled by :c:func:`server_setup_peers`, as are the following.
+ *
+ *  .. c:member:: lpid_t *partition_peers
+ *
+ *  The lpids of the other servers of the same replica, by partition.
+ *
+ *  .. c:member:: lpid_t parent_lpid
+ *
+ *  The lpid of the parent in the tree of partitions, except for partition 0.
+ *
+ *  .. c:member:: lpid_t *children_lpids
+ *
+ *  The lpids of the children in the tree of partitions.
  */
+typedef enum {
+	GST_TOPOLOGY_TREE, // LSTs are aggregated up the tree, GST sent down
+	GST_TOPOLOGY_BROADCAST, // Each partition sends its LST to every other
+} gst_topology_t;
+
 typedef struct server_config {
 	cluster_config_t *cluster;
 	network_config_t *network;
@@ -50,7 +77,15 @@ typedef struct server_config {
 	partition_t partition;
 	replica_t replica; // The replica the server belongs to
 	unsigned int tree_fanout;
+	gst_topology_t gst_topology;
 	unsigned int num_cores;
+	lpid_t *replica_peers;
+	unsigned int num_replica_peers;
+	lpid_t *partition_peers;
+	unsigned int num_partition_peers;
+	lpid_t parent_lpid;
+	lpid_t *children_lpids;
+	unsigned int num_children;
 } server_config_t;
 
 /** .. c:type:: server_state_t
@@ -94,6 +129,10 @@ typedef struct server_config {
  *
  *  An instance of :c:type:`network_state_t` storing
  *  network-related state and statistics.
+ *
+ *  .. c:member:: messages
+ *
+ *  The pool of buffers in which outgoing messages are built.
  */
 
 #define SERVER_STATE_STRUCT(NAME) \
@@ -108,13 +147,22 @@ typedef struct server_config {
 		cpu_state_t *cpu; \
 		network_state_t *network; \
 		server_clock_skew_state_t clock_skew; \
+		message_pool_t *messages; \
 	}
 
 SERVER_STATE_STRUCT(server_state);
 
 void server_setup(lpid_t lpid, cluster_config_t *cluster, replica_t replica,
 		partition_t partition, network_config_t *network,
-		unsigned int tree_fanout, unsigned int num_cores);
+		unsigned int tree_fanout, gst_topology_t gst_topology,
+		unsigned int num_cores);
+
+/** .. c:function:: void server_setup_peers(lpid_t lpid)
+ *
+ *  Fill the peer tables of the configuration of a server. Must be called once
+ *  all the servers of the cluster are set up.
+ */
+void server_setup_peers(lpid_t lpid);
 
 /** .. c:function:: void server_schedule_self(server_state_t *state, simtime_t delay, unsigned int event_type, void *data, size_t data_size)
  *
@@ -134,6 +182,14 @@ void server_schedule_self(server_state_t *state, simtime_t delay,
 void server_send(server_state_t *state, lpid_t to_lpid,
 		unsigned int event_type, message_t *message);
 
+/** .. c:function:: void server_multicast(server_state_t *state, const lpid_t *to_lpids, unsigned int num_lpids, unsigned int event_type, message_t *message)
+ *
+ *  Send the same event to several servers, as with :c:func:`server_send`
+ *  called for each of them in order.
+ */
+void server_multicast(server_state_t *state, const lpid_t *to_lpids,
+		unsigned int num_lpids, unsigned int event_type, message_t *message);
+
 unsigned int server_parent_partition_id(server_state_t *state);
 unsigned int server_child_partition_index(server_state_t *state,
 		unsigned int partition_id);
@@ -141,7 +197,5 @@ unsigned int server_first_child_id(server_state_t *state);
 unsigned int server_last_child_id(server_state_t *state);
 int server_is_leaf_partition(server_state_t *state);
 unsigned int server_num_children_partitions(server_state_t *state);
-void server_foreach_children_partition(server_state_t *state,
-		void (*f)(partition_t partition, void *data), void *data);
 
 #endif
@@ -1,30 +1,18 @@
 #include "server/stats.h"
+#include "histogram.h"
 #include "output.h"
 #include "parameters.h"
 #include "server.h"
 #include <assert.h>
 #include <json.h>
 
-#define average_stat(stats, name, average_ptr) \
-	do { \
-		*average_ptr = 0; \
-		if (stats->name##_index == 0) break; \
-		for (unsigned int i = 0; i < stats->name##_index; ++i) { \
-			*average_ptr += stats->name[i]; \
-		} \
-		*average_ptr = (double) *average_ptr / (double) stats->name##_index; \
-	} while (0);
-
-#define clear_stat(stats, name) \
-	stats->name##_index = 0;
-
 typedef unsigned int server_stats_array_id_t;
 
+// Samples are accumulated rather than stored so that the memory used does
+// not grow with the length of the simulation.
 typedef struct {
 	char *name;
-	double *values;
-	unsigned int next_index;
-	unsigned int size;
+	histogram_t samples;
 } stat_array_t;
 
 typedef struct {
@@ -43,22 +31,13 @@ static server_stats_array_id_t stats_array_new(server_stats_t *stats,
 		const char *name)
 {
 	server_stats_array_id_t id = stats->num_arrays;
-	stat_array_t *array = calloc(1, sizeof(stat_array_t));
+	stat_array_t *array = malloc(sizeof(stat_array_t));
 	array->name = mallocstrcy(name);
+	histogram_init(&array->samples);
 	array_push(&stats->arrays, &stats->num_arrays, array);
 	return id;
 }
 
-static double stats_array_average(stat_array_t *array)
-{
-	double average = 0;
-	if (array->next_index == 0) return 0;
-	for (unsigned int i = 0; i < array->next_index; ++i) {
-		average += array->values[i];
-	}
-	return average / (double) array->next_index; \
-}
-
 static server_stats_counter_id_t stats_counter_new(server_stats_t *stats,
 		const char *name)
 {
@@ -104,8 +83,7 @@ void server_stats_array_push(server_state_t* state,
 {
 	assert(id < state->stats->num_arrays);
 	if (state->now < app_params.ignore_initial_seconds) return;
-	stat_array_t *stat = state->stats->arrays[id];
-	parray_push(&stat->values, &stat->next_index, &stat->size, value);
+	histogram_add(&state->stats->arrays[id]->samples, value);
 }
 
 server_stats_counter_id_t server_stats_counter_new(server_state_t *state,
@@ -142,25 +120,7 @@ void server_stats_output(server_state_t *state, struct json_object *top)
 	// Arrays
 	for (unsigned int i = 0; i < stats->num_arrays; ++i) {
 		struct json_object *obj = json_object_new_object();
-		json_object_object_add(obj, "sample size",
-				json_object_new_int64(stats->arrays[i]->next_index));
-		json_object_object_add(obj, "average",
-				json_object_new_double(stats_array_average(stats->arrays[i])));
+		histogram_output(&stats->arrays[i]->samples, obj, 1);
 		json_object_object_add(top, stats->arrays[i]->name, obj);
 	}
-
-	// FIXME This might be useful to do it for every array
-	// Output each visibility latency sample
-	const size_t buf_size = 32;
-	char buf[buf_size];
-	snprintf(buf, buf_size, "_visibility");
-	FILE *f_visibility = output_server_open_suffix(state->config->replica,
-			state->config->partition, buf);
-	if (f_visibility != NULL) {
-		for (unsigned int i = 0; i < stats->arrays[VISIBILITY_LATENCY]->next_index; ++i) {
-			fprintf(f_visibility, "%f\n",
-					stats->arrays[VISIBILITY_LATENCY]->values[i]);
-		}
-		fclose(f_visibility);
-	}
 }
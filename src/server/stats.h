@@ -73,15 +73,18 @@ typedef unsigned int server_stats_counter_id_t;
 
 /** .. c:function:: server_stats_array_id_t server_stats_array_new(server_state_t*, const char* name)
  *
- *  Create a new array. The average and number of samples will be found in the
+ *  Create a new array. The number of samples, their average, standard
+ *  deviation, extrema, percentiles and histogram will be found in the
  *  simulation output with the given name. Use the returned id with
- *  :c:func:`server_stats_array_push` to add values to the array.
+ *  :c:func:`server_stats_array_push` to add values to the array. Despite its
+ *  name, an array does not store the samples, it uses a constant amount of
+ *  memory (see `src/histogram.h`).
  */
 server_stats_array_id_t server_stats_array_new(server_state_t*, const char* name);
 
 /** .. c:function:: void server_stats_array_push(server_state_t*, server_stats_array_id_t, double)
  *
- *  Append a value to the given array. Use :c:func:`server_stats_array_new` to
+ *  Add a sample to the given array. Use :c:func:`server_stats_array_new` to
  *  create a new array.
  */
 void server_stats_array_push(server_state_t*, server_stats_array_id_t, double);
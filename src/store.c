@@ -1,68 +1,183 @@
+#include <assert.h>
 #include <stdlib.h>
 #include "store.h"
 
-typedef struct store_item store_item_t;
+#define INITIAL_STORE_SIZE 1024 // Must be a power of two
 
+typedef struct store_entry store_entry_t;
+
+/* Unless it is dense, the store is an open-addressing hash table using linear
+ * probing and Robin Hood insertion, entries with a NULL value are empty. Keys
+ * and values are kept next to each other so that a lookup usually touches a
+ * single cache line. */
 struct store {
-	unsigned int num_buckets;
-	store_item_t **buckets;
+	int dense;
+	// Hash table
+	unsigned int size; // Number of non-empty entries
+	unsigned int mask; // Number of entries minus one
+	store_entry_t *entries;
+	// Dense store, the value of key offset + i * stride is values[i]
+	gr_key offset;
+	gr_key stride;
+	gr_key num_values;
+	void **values;
 };
 
-struct store_item {
+struct store_entry {
 	gr_key key;
 	void *value;
-	store_item_t *next;
 };
 
-static unsigned int hash(store_t *store, gr_key key)
+static unsigned int home_slot(store_t *store, gr_key key)
+{
+	// Fibonacci hashing, keys are often allocated to partitions by their
+	// remainder so their low bits alone do not spread well.
+	return (unsigned int) ((key * 11400714819323198485ull) >> 32) & store->mask;
+}
+
+static unsigned int probe_distance(store_t *store, gr_key key,
+		unsigned int slot)
+{
+	return (slot - home_slot(store, key)) & store->mask;
+}
+
+static store_entry_t *allocate_entries(unsigned int num_entries)
+{
+	store_entry_t *entries = malloc(num_entries * sizeof(store_entry_t));
+	for (unsigned int i = 0; i < num_entries; ++i) {
+		entries[i].value = NULL;
+	}
+	return entries;
+}
+
+static void insert_new(store_t *store, gr_key key, void *value)
 {
-	return (unsigned int) (key % (store->num_buckets));
+	unsigned int slot = home_slot(store, key);
+	unsigned int distance = 0;
+	while (store->entries[slot].value != NULL) {
+		store_entry_t *entry = &store->entries[slot];
+		unsigned int entry_distance = probe_distance(store, entry->key, slot);
+		if (entry_distance < distance) {
+			// Take the place of the entry closer to its home slot and carry
+			// on with inserting it instead.
+			store_entry_t displaced = *entry;
+			entry->key = key;
+			entry->value = value;
+			key = displaced.key;
+			value = displaced.value;
+			distance = entry_distance;
+		}
+		slot = (slot + 1) & store->mask;
+		++distance;
+	}
+	store->entries[slot].key = key;
+	store->entries[slot].value = value;
+	++store->size;
+}
+
+static void grow(store_t *store)
+{
+	store_entry_t *old_entries = store->entries;
+	unsigned int old_num_entries = store->mask + 1;
+	store->mask = 2 * old_num_entries - 1;
+	store->entries = allocate_entries(2 * old_num_entries);
+	store->size = 0;
+	for (unsigned int i = 0; i < old_num_entries; ++i) {
+		if (old_entries[i].value != NULL) {
+			insert_new(store, old_entries[i].key, old_entries[i].value);
+		}
+	}
+	free(old_entries);
 }
 
 store_t *store_new(void)
 {
-	const unsigned int buckets_per_store = 32768;
 	store_t *store = malloc(sizeof(store_t));
-	store->num_buckets = buckets_per_store;
-	store->buckets = calloc(buckets_per_store, sizeof(store_item_t*));
+	store->dense = 0;
+	store->size = 0;
+	store->mask = INITIAL_STORE_SIZE - 1;
+	store->entries = allocate_entries(INITIAL_STORE_SIZE);
 	return store;
 }
 
-void *store_get(store_t *store, gr_key key)
+store_t *store_new_dense(gr_key offset, gr_key stride, gr_key num_values)
+{
+	assert(stride > 0);
+	store_t *store = malloc(sizeof(store_t));
+	store->dense = 1;
+	store->offset = offset;
+	store->stride = stride;
+	store->num_values = num_values;
+	store->values = calloc(num_values, sizeof(void*));
+	return store;
+}
+
+static void **dense_value(store_t *store, gr_key key)
+{
+	assert(key >= store->offset);
+	assert((key - store->offset) % store->stride == 0);
+	gr_key index = (key - store->offset) / store->stride;
+	assert(index < store->num_values);
+	return &store->values[index];
+}
+
+static store_entry_t *find_entry(store_t *store, gr_key key)
 {
-	store_item_t *item = store->buckets[hash(store, key)];
-	while (item != NULL && item->key != key) {
-		item = item->next;
+	unsigned int slot = home_slot(store, key);
+	unsigned int distance = 0;
+	while (1) {
+		store_entry_t *entry = &store->entries[slot];
+		if (entry->value == NULL) return NULL;
+		if (entry->key == key) return entry;
+		// With Robin Hood insertion the key would have been stored before any
+		// entry closer to its home slot than the key would be.
+		if (probe_distance(store, entry->key, slot) < distance) return NULL;
+		slot = (slot + 1) & store->mask;
+		++distance;
 	}
+}
 
-	if (item == NULL) return NULL;
-	return item->value;
+void *store_get(store_t *store, gr_key key)
+{
+	if (store->dense) return *dense_value(store, key);
+	store_entry_t *entry = find_entry(store, key);
+	if (entry == NULL) return NULL;
+	return entry->value;
 }
 
 void store_put(store_t *store, gr_key key, void *value)
 {
-	store_item_t **item = &store->buckets[hash(store, key)];
-	while (*item != NULL) {
-		if ((*item)->key == key) {
-			(*item)->value = value;
-			return;
-		}
-		item = &(*item)->next;
+	assert(value != NULL);
+	if (store->dense) {
+		*dense_value(store, key) = value;
+		return;
 	}
-	store_item_t *new_item = malloc(sizeof(store_item_t));
-	new_item->key = key;
-	new_item->value = value;
-	new_item->next = NULL;
-	*item = new_item;
+	store_entry_t *entry = find_entry(store, key);
+	if (entry != NULL) {
+		entry->value = value;
+		return;
+	}
+	// Keep the load factor under 3/4 so that probe sequences stay short.
+	if (4 * (store->size + 1) > 3 * (store->mask + 1)) {
+		grow(store);
+	}
+	insert_new(store, key, value);
 }
 
 void store_foreach_item(store_t *store, void (*fun)(gr_key key, void *value))
 {
-	for (unsigned int i = 0; i < store->num_buckets; ++i) {
-		store_item_t *item = store->buckets[i];
-		while (item != NULL) {
-			fun(item->key, item->value);
-			item = item->next;
+	if (store->dense) {
+		for (gr_key i = 0; i < store->num_values; ++i) {
+			if (store->values[i] != NULL) {
+				fun(store->offset + i * store->stride, store->values[i]);
+			}
+		}
+		return;
+	}
+	for (unsigned int i = 0; i <= store->mask; ++i) {
+		store_entry_t *entry = &store->entries[i];
+		if (entry->value != NULL) {
+			fun(entry->key, entry->value);
 		}
 	}
 }
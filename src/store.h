@@ -12,7 +12,13 @@
 typedef struct store store_t;
 
 store_t *store_new(void);
+
+/* Create a store for the num_values keys offset + i * stride, with i in
+ * [0, num_values), whose values are directly indexed in an array. */
+store_t *store_new_dense(gr_key offset, gr_key stride, gr_key num_values);
+
 void *store_get(store_t *store, gr_key key);
+/* Associate the given non-NULL value to the key, replacing any previous one. */
 void store_put(store_t *store, gr_key key, void *value);
 void store_foreach_item(store_t *store, void (*fun)(gr_key key, void *value));
 